@@ -0,0 +1,146 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <algorithm>
+#include <array>
+#include <new>
+
+#if defined( _WIN32 )
+#    include <windows.h> // RtlCaptureStackBackTrace.
+#endif
+
+#include "allocation.hpp"
+
+// The address operator new returns to, i.e. the allocating call site. Taken in operator new itself, as anything it
+// calls only sees the allocator.
+#if defined( _MSC_VER ) and not defined( __clang__ )
+#    include <intrin.h>
+#    define PONG_CALLER( ) _ReturnAddress ( )
+#else
+#    define PONG_CALLER( ) __builtin_return_address ( 0 )
+#endif
+
+namespace pong::allocation::detail {
+namespace {
+
+void record ( const std::size_t size_, void * const caller_ ) noexcept {
+    if ( not t_counting ) {
+        return;
+    }
+    ++t_statistics.count;
+    t_statistics.bytes += size_;
+    if ( t_tracing and t_call_site_count < t_call_sites.size ( ) ) {
+        CallSite & site  = t_call_sites[ t_call_site_count++ ];
+        site.size        = size_;
+        site.frames      = { };
+        site.frames[ 0 ] = caller_;
+#if defined( _WIN32 )
+        // The frames from the call site outwards, found by its address, however much of the allocator got inlined.
+        std::array<void *, CallSite::depth + 8u> frames{ };
+        void ** const end =
+            frames.data ( ) + RtlCaptureStackBackTrace ( 0u, ( DWORD ) frames.size ( ), frames.data ( ), nullptr );
+        void ** const first = std::find ( frames.data ( ), end, caller_ );
+        std::copy ( first, std::min ( end, first + CallSite::depth ), site.frames.data ( ) );
+#endif // Without a portable unwinder, only the innermost frame.
+    }
+}
+
+void * allocate ( const std::size_t size_, void * const caller_ ) {
+    record ( size_, caller_ );
+    if ( void * p = std::malloc ( size_ ? size_ : 1u ) ) {
+        return p;
+    }
+    throw std::bad_alloc ( );
+}
+
+void * allocate ( const std::size_t size_, const std::align_val_t alignment_, void * const caller_ ) {
+    record ( size_, caller_ );
+    const std::size_t alignment = ( std::size_t ) alignment_;
+#if defined( _WIN32 )
+    if ( void * p = _aligned_malloc ( size_ ? size_ : 1u, alignment ) ) {
+#else
+    if ( void * p = std::aligned_alloc ( alignment, ( ( size_ ? size_ : 1u ) + alignment - 1u ) / alignment * alignment ) ) {
+#endif
+        return p;
+    }
+    throw std::bad_alloc ( );
+}
+
+void deallocate_aligned ( void * p_ ) noexcept {
+#if defined( _WIN32 )
+    _aligned_free ( p_ );
+#else
+    std::free ( p_ );
+#endif
+}
+} // namespace
+} // namespace pong::allocation::detail
+
+// The replaceable global allocation functions, not inlined, so PONG_CALLER ( ) is the allocating call site.
+
+[[gnu::noinline]] void * operator new ( std::size_t size_ ) {
+    return pong::allocation::detail::allocate ( size_, PONG_CALLER ( ) );
+}
+[[gnu::noinline]] void * operator new[] ( std::size_t size_ ) {
+    return pong::allocation::detail::allocate ( size_, PONG_CALLER ( ) );
+}
+[[gnu::noinline]] void * operator new ( std::size_t size_, const std::nothrow_t & ) noexcept {
+    try {
+        return pong::allocation::detail::allocate ( size_, PONG_CALLER ( ) );
+    }
+    catch ( ... ) {
+        return nullptr;
+    }
+}
+[[gnu::noinline]] void * operator new[] ( std::size_t size_, const std::nothrow_t & ) noexcept {
+    try {
+        return pong::allocation::detail::allocate ( size_, PONG_CALLER ( ) );
+    }
+    catch ( ... ) {
+        return nullptr;
+    }
+}
+[[gnu::noinline]] void * operator new ( std::size_t size_, std::align_val_t alignment_ ) {
+    return pong::allocation::detail::allocate ( size_, alignment_, PONG_CALLER ( ) );
+}
+[[gnu::noinline]] void * operator new[] ( std::size_t size_, std::align_val_t alignment_ ) {
+    return pong::allocation::detail::allocate ( size_, alignment_, PONG_CALLER ( ) );
+}
+
+void operator delete ( void * p_ ) noexcept { std::free ( p_ ); }
+void operator delete[] ( void * p_ ) noexcept { std::free ( p_ ); }
+void operator delete ( void * p_, std::size_t ) noexcept { std::free ( p_ ); }
+void operator delete[] ( void * p_, std::size_t ) noexcept { std::free ( p_ ); }
+void operator delete ( void * p_, const std::nothrow_t & ) noexcept { std::free ( p_ ); }
+void operator delete[] ( void * p_, const std::nothrow_t & ) noexcept { std::free ( p_ ); }
+void operator delete ( void * p_, std::align_val_t ) noexcept { pong::allocation::detail::deallocate_aligned ( p_ ); }
+void operator delete[] ( void * p_, std::align_val_t ) noexcept { pong::allocation::detail::deallocate_aligned ( p_ ); }
+void operator delete ( void * p_, std::size_t, std::align_val_t ) noexcept {
+    pong::allocation::detail::deallocate_aligned ( p_ );
+}
+void operator delete[] ( void * p_, std::size_t, std::align_val_t ) noexcept {
+    pong::allocation::detail::deallocate_aligned ( p_ );
+}
@@ -0,0 +1,98 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+#include <array>
+#include <ostream>
+
+// Counting (and optionally tracing) global allocation functions.
+//
+// The replacements of the global operator new/delete are in allocation.cpp, this is what's needed to count with them,
+// from any translation unit. Counting is per thread and off by default, a Counter switches it on for the calling thread
+// only, so the spectator and export threads don't show up in the numbers of the game loop. Recording never allocates.
+
+namespace pong::allocation {
+
+struct Statistics {
+    std::size_t count = 0u, bytes = 0u;
+};
+
+// The return addresses of an allocation, innermost first.
+struct CallSite {
+    static constexpr std::size_t depth = 6u;
+    std::array<void *, depth> frames{ };
+    std::size_t size = 0u; // Bytes.
+};
+
+namespace detail {
+
+inline thread_local bool t_counting = false, t_tracing = false;
+inline thread_local Statistics t_statistics;
+inline thread_local std::array<CallSite, 64> t_call_sites;
+inline thread_local std::size_t t_call_site_count = 0u;
+} // namespace detail
+
+// Counts the allocations of the calling thread between start ( ) and stop ( ), with tracing also records (up to 64 of)
+// their call sites.
+class Counter {
+
+    public:
+    explicit Counter ( const bool trace_ = false ) noexcept : m_trace ( trace_ ) {}
+    Counter ( const Counter & ) = delete;
+    ~Counter ( ) noexcept { detail::t_counting = false, detail::t_tracing = false; }
+
+    void start ( ) noexcept {
+        detail::t_statistics = { }, detail::t_call_site_count = 0u;
+        detail::t_tracing = m_trace, detail::t_counting = true;
+    }
+
+    Statistics stop ( ) noexcept {
+        detail::t_counting = false, detail::t_tracing = false;
+        return detail::t_statistics;
+    }
+
+    // The call sites recorded between the last start ( ) and stop ( ), as raw addresses (symbolize with the pdb, f.e.
+    // llvm-symbolizer --obj=pong.exe).
+    void report ( std::ostream & out_ ) const {
+        for ( std::size_t i = 0; i < detail::t_call_site_count; ++i ) {
+            const CallSite & site = detail::t_call_sites[ i ];
+            out_ << "    " << site.size << " bytes at";
+            for ( void * frame : site.frames ) {
+                if ( frame ) {
+                    out_ << ' ' << frame;
+                }
+            }
+            out_ << '\n';
+        }
+        if ( detail::t_statistics.count > detail::t_call_site_count ) {
+            out_ << "    (" << detail::t_statistics.count - detail::t_call_site_count << " more)\n";
+        }
+    }
+
+    private:
+    bool m_trace;
+};
+} // namespace pong::allocation
@@ -0,0 +1,168 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#if defined( _WIN32 )
+#    include <windows.h>
+#    include <psapi.h> // K32GetProcessMemoryInfo.
+#else
+#    include <sys/resource.h> // getrusage.
+#endif
+
+#include <SFML/Audio.hpp>
+#include <SFML/Extensions.hpp>
+#include <SFML/Graphics.hpp>
+
+namespace pong {
+
+namespace detail {
+
+template<typename T>
+struct AssetEntry {
+    int id;
+    T value;
+    std::once_flag loaded;
+    std::size_t bytes = 0u;
+};
+
+// Estimates of the memory an asset keeps resident (textures on the gpu, the rest on the heap).
+inline std::size_t resident_bytes ( const sf::Texture & t_ ) noexcept { return 4u * t_.getSize ( ).x * t_.getSize ( ).y; }
+inline std::size_t resident_bytes ( const sf::Image & i_ ) noexcept { return 4u * i_.getSize ( ).x * i_.getSize ( ).y; }
+inline std::size_t resident_bytes ( const sf::SoundBuffer & s_ ) noexcept {
+    return sizeof ( sf::Int16 ) * ( std::size_t ) s_.getSampleCount ( );
+}
+
+// State set once, at load, as the handles share the asset: textures are loaded smooth (for all their users).
+inline void prepare ( sf::Texture & t_ ) noexcept { t_.setSmooth ( true ); }
+template<typename T>
+void prepare ( T & ) noexcept {}
+} // namespace detail
+
+// A shared handle to an asset of an AssetCache. The asset is loaded (once, thread-safe) on first use and freed with the
+// last handle, an empty handle refers to nothing. The asset is shared, so it's read-only.
+template<typename T>
+class Asset {
+
+    public:
+    Asset ( ) noexcept = default;
+
+    const T & get ( ) const {
+        std::call_once ( m_entry->loaded, [ e = m_entry.get ( ) ] {
+            sf::loadFromResource ( e->value, e->id );
+            detail::prepare ( e->value );
+            e->bytes = detail::resident_bytes ( e->value );
+        } );
+        return m_entry->value;
+    }
+
+    const T & operator* ( ) const { return get ( ); }
+    const T * operator-> ( ) const { return &get ( ); }
+
+    explicit operator bool ( ) const noexcept { return ( bool ) m_entry; }
+
+    private:
+    friend class AssetCache;
+
+    explicit Asset ( std::shared_ptr<detail::AssetEntry<T>> entry_ ) noexcept : m_entry ( std::move ( entry_ ) ) {}
+
+    std::shared_ptr<detail::AssetEntry<T>> m_entry;
+};
+
+// Hands out handles to the resources compiled into the executable (resource.h), all handles to the same resource (and
+// type) share one copy. The cache doesn't own the assets, the handles do.
+class AssetCache {
+
+    public:
+    template<typename T>
+    [[nodiscard]] Asset<T> acquire ( const int id_ ) {
+        std::scoped_lock lock ( m_mutex );
+        auto & entries = std::get<Entries<T>> ( m_entries );
+        for ( const auto & weak : entries ) {
+            if ( auto entry = weak.lock ( ); entry and id_ == entry->id ) {
+                return Asset<T> ( std::move ( entry ) );
+            }
+        }
+        auto entry = std::make_shared<detail::AssetEntry<T>> ( );
+        entry->id  = id_;
+        // Forget the freed ones.
+        entries.erase ( std::remove_if ( entries.begin ( ), entries.end ( ), [ ] ( const auto & w_ ) { return w_.expired ( ); } ),
+                        entries.end ( ) );
+        entries.push_back ( entry );
+        return Asset<T> ( std::move ( entry ) );
+    }
+
+    // Lists the live assets (loaded or not), with their (estimated) resident size, and the peak resident set of the process.
+    void report ( std::ostream & out_ ) {
+        std::scoped_lock lock ( m_mutex );
+        std::size_t total = 0u;
+        out_ << "assets:\n";
+        auto list = [ & ] ( const char * type_, auto & entries_ ) {
+            for ( const auto & weak : entries_ ) {
+                if ( auto entry = weak.lock ( ) ) {
+                    out_ << "    " << type_ << " " << entry->id << ": " << ( entry->bytes / 1024u ) << " KiB"
+                         << ( entry->bytes ? "" : " (not loaded)" ) << " in " << ( entry.use_count ( ) - 1 ) << " handle(s)\n";
+                    total += entry->bytes;
+                }
+            }
+        };
+        list ( "texture", std::get<Entries<sf::Texture>> ( m_entries ) );
+        list ( "image", std::get<Entries<sf::Image>> ( m_entries ) );
+        list ( "sound", std::get<Entries<sf::SoundBuffer>> ( m_entries ) );
+        out_ << "    total " << ( total / 1024u ) << " KiB, peak resident set of the process "
+             << ( peak_resident_bytes ( ) / 1024u ) << " KiB\n";
+    }
+
+    static std::size_t peak_resident_bytes ( ) noexcept {
+#if defined( _WIN32 )
+        PROCESS_MEMORY_COUNTERS counters{ };
+        counters.cb = sizeof ( counters );
+        if ( not K32GetProcessMemoryInfo ( GetCurrentProcess ( ), &counters, sizeof ( counters ) ) ) {
+            return 0u;
+        }
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{ };
+        return getrusage ( RUSAGE_SELF, &usage ) ? 0u : 1024u * ( std::size_t ) usage.ru_maxrss;
+#endif
+    }
+
+    private:
+    template<typename T>
+    using Entries = std::vector<std::weak_ptr<detail::AssetEntry<T>>>;
+
+    std::mutex m_mutex;
+    std::tuple<Entries<sf::Texture>, Entries<sf::Image>, Entries<sf::SoundBuffer>> m_entries;
+};
+} // namespace pong
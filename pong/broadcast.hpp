@@ -0,0 +1,358 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/Network.hpp>
+
+// Spectator broadcast: the game publishes a snapshot every tick, a fan-out thread encodes it once and sends the same
+// datagram to every subscribed viewer.
+//
+// Protocol (udp, little endian). A viewer subscribes by sending hello to the server, and keeps sending it at least
+// every timeout / 2 (it's also the heartbeat), bye unsubscribes. The server sends a key frame (all fields) every
+// key_interval ticks and delta frames in between. A delta holds the fields that changed w.r.t. the last key frame
+// (not the last frame), so a lost delta costs nothing and a lost key frame costs at most key_interval ticks.
+
+namespace pong::broadcast {
+
+enum class Message : std::uint8_t { Hello = 'H', Bye = 'B' };
+
+struct Snapshot {
+
+    enum Field : std::uint8_t { BallX, BallY, BallAngle, LeftY, RightY, ScoreLeft, ScoreRight, FieldCount };
+
+    std::uint32_t tick = 0u;
+    std::array<std::uint16_t, FieldCount> fields{ };
+
+    // Positions in 1/8th pixel, angles in 1/65536th turn.
+    static constexpr std::uint16_t quantize_position ( const float p_ ) noexcept {
+        return ( std::uint16_t ) ( std::int16_t ) ( p_ * 8.0f + ( p_ < 0.0f ? -0.5f : 0.5f ) );
+    }
+    static constexpr float position ( const std::uint16_t q_ ) noexcept { return ( std::int16_t ) q_ / 8.0f; }
+    static std::uint16_t quantize_angle ( const float radians_ ) noexcept {
+        return ( std::uint16_t ) ( std::int32_t ) std::round ( radians_ * ( 65'536.0f / 6.283'185'307f ) );
+    }
+    static constexpr float angle ( const std::uint16_t q_ ) noexcept { return q_ * ( 6.283'185'307f / 65'536.0f ); }
+};
+
+struct Codec {
+
+    static constexpr std::uint8_t magic = 'P', version = 1u;
+    enum class Type : std::uint8_t { Key = 0, Delta = 1 };
+
+    static constexpr std::size_t header_size = 12u; // magic, version, type, mask, tick, key tick.
+    static constexpr std::size_t max_size    = header_size + 2u * Snapshot::FieldCount;
+
+    using Packet = std::array<std::uint8_t, max_size>;
+
+    // Returns the size of the encoding in out_, key_ is the last key frame (equal to snapshot_ for a key frame).
+    static std::size_t encode ( const Snapshot & snapshot_, const Snapshot & key_, Packet & out_ ) noexcept {
+        const bool is_key = snapshot_.tick == key_.tick;
+        std::uint8_t mask = 0u;
+        std::size_t size  = header_size;
+        for ( std::size_t f = 0; f < Snapshot::FieldCount; ++f ) {
+            if ( is_key or snapshot_.fields[ f ] != key_.fields[ f ] ) {
+                mask |= ( std::uint8_t ) ( 1u << f );
+                size = put16 ( out_, size, snapshot_.fields[ f ] );
+            }
+        }
+        out_[ 0 ] = magic, out_[ 1 ] = version, out_[ 2 ] = ( std::uint8_t ) ( is_key ? Type::Key : Type::Delta ), out_[ 3 ] = mask;
+        put32 ( out_, 4u, snapshot_.tick );
+        put32 ( out_, 8u, key_.tick );
+        return size;
+    }
+
+    // Decodes into snapshot_, key_ is the viewer's last key frame and is updated on a key frame. Returns false if the
+    // packet is malformed or refers to a key frame the viewer doesn't have.
+    static bool decode ( const std::uint8_t * data_, const std::size_t size_, Snapshot & key_, Snapshot & snapshot_ ) noexcept {
+        if ( size_ < header_size or magic != data_[ 0 ] or version != data_[ 1 ] ) {
+            return false;
+        }
+        const Type type = ( Type ) data_[ 2 ];
+        const std::uint8_t mask = data_[ 3 ];
+        const std::uint32_t tick = get32 ( data_ + 4 ), key_tick = get32 ( data_ + 8 );
+        if ( Type::Delta == type and key_tick != key_.tick ) {
+            return false;
+        }
+        Snapshot result = Type::Key == type ? Snapshot{ } : key_;
+        std::size_t at  = header_size;
+        for ( std::size_t f = 0; f < Snapshot::FieldCount; ++f ) {
+            if ( mask & ( 1u << f ) ) {
+                if ( at + 2u > size_ ) {
+                    return false;
+                }
+                result.fields[ f ] = ( std::uint16_t ) ( data_[ at ] | data_[ at + 1 ] << 8 );
+                at += 2u;
+            }
+        }
+        result.tick = tick;
+        if ( Type::Key == type ) {
+            key_ = result;
+        }
+        snapshot_ = result;
+        return true;
+    }
+
+    private:
+    static std::size_t put16 ( Packet & out_, const std::size_t at_, const std::uint16_t v_ ) noexcept {
+        out_[ at_ ] = ( std::uint8_t ) v_, out_[ at_ + 1u ] = ( std::uint8_t ) ( v_ >> 8 );
+        return at_ + 2u;
+    }
+    static void put32 ( Packet & out_, const std::size_t at_, const std::uint32_t v_ ) noexcept {
+        for ( std::size_t i = 0; i < 4u; ++i ) {
+            out_[ at_ + i ] = ( std::uint8_t ) ( v_ >> ( 8u * i ) );
+        }
+    }
+    static std::uint32_t get32 ( const std::uint8_t * p_ ) noexcept {
+        return ( std::uint32_t ) p_[ 0 ] | ( std::uint32_t ) p_[ 1 ] << 8 | ( std::uint32_t ) p_[ 2 ] << 16 |
+               ( std::uint32_t ) p_[ 3 ] << 24;
+    }
+};
+
+class Server {
+
+    public:
+    static constexpr std::uint32_t key_interval = 30u;
+    static constexpr std::chrono::seconds timeout{ 5 };
+
+    Server ( ) = default;
+    Server ( const Server & ) = delete;
+    ~Server ( ) { stop ( ); }
+
+    bool start ( const unsigned short port_ ) {
+        if ( sf::Socket::Done != m_socket.bind ( port_ ) ) {
+            return false;
+        }
+        m_socket.setBlocking ( false );
+        m_running = true;
+        m_thread  = std::thread ( [ this ] { fan_out ( ); } );
+        return true;
+    }
+
+    void stop ( ) {
+        if ( m_running.exchange ( false ) ) {
+            m_has_snapshot.notify_one ( );
+            m_thread.join ( );
+            m_socket.unbind ( );
+        }
+    }
+
+    // Called by the game loop, only copies the snapshot, a newer snapshot replaces one that hasn't been sent yet.
+    void publish ( const Snapshot & snapshot_ ) noexcept {
+        {
+            std::scoped_lock lock ( m_mutex );
+            m_mailbox     = snapshot_;
+            m_has_mailbox = true;
+        }
+        m_has_snapshot.notify_one ( );
+    }
+
+    std::size_t viewers ( ) const noexcept { return m_viewer_count.load ( std::memory_order_relaxed ); }
+
+    private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Viewer {
+        sf::IpAddress address;
+        unsigned short port;
+        Clock::time_point last_seen;
+    };
+
+    static std::uint64_t key ( const sf::IpAddress & address_, const unsigned short port_ ) noexcept {
+        return ( std::uint64_t ) address_.toInteger ( ) << 16 | port_;
+    }
+
+    void fan_out ( ) {
+        Snapshot snapshot, key_frame;
+        key_frame.tick = ~0u;
+        Codec::Packet packet;
+        while ( m_running ) {
+            bool has_snapshot = false;
+            {
+                std::unique_lock<std::mutex> lock ( m_mutex );
+                m_has_snapshot.wait_for ( lock, std::chrono::milliseconds ( 100 ),
+                                          [ this ] { return m_has_mailbox or not m_running; } );
+                if ( m_has_mailbox ) {
+                    snapshot      = m_mailbox;
+                    m_has_mailbox = false;
+                    has_snapshot  = true;
+                }
+            }
+            receive ( );
+            if ( not has_snapshot ) {
+                continue;
+            }
+            if ( ~0u == key_frame.tick or snapshot.tick - key_frame.tick >= key_interval ) {
+                key_frame = snapshot;
+            }
+            // One encoding, sent to everybody.
+            const std::size_t size = Codec::encode ( snapshot, key_frame, packet );
+            for ( const Viewer & viewer : m_viewers ) {
+                m_socket.send ( packet.data ( ), size, viewer.address, viewer.port ); // NotReady (full buffer) drops the frame.
+            }
+        }
+    }
+
+    // Handles hello's and bye's and drops the viewers that have timed out. Drains the socket, anything that isn't a
+    // message (any size datagram, or the reset a gone viewer's port answers with on windows) is skipped.
+    void receive ( ) {
+        const Clock::time_point now = Clock::now ( );
+        std::size_t size;
+        sf::IpAddress address;
+        unsigned short port;
+        while ( true ) {
+            const sf::Socket::Status status = m_socket.receive ( m_datagram.data ( ), m_datagram.size ( ), size, address, port );
+            if ( sf::Socket::NotReady == status or sf::Socket::Error == status ) {
+                break;
+            }
+            if ( sf::Socket::Done != status or 1u != size ) {
+                continue;
+            }
+            const std::uint64_t k = key ( address, port );
+            const auto it         = m_index.find ( k );
+            if ( ( std::uint8_t ) Message::Hello == m_datagram[ 0 ] ) {
+                if ( m_index.end ( ) == it ) {
+                    m_index.emplace ( k, m_viewers.size ( ) );
+                    m_viewers.push_back ( { address, port, now } );
+                }
+                else {
+                    m_viewers[ it->second ].last_seen = now;
+                }
+            }
+            else if ( ( std::uint8_t ) Message::Bye == m_datagram[ 0 ] and m_index.end ( ) != it ) {
+                m_viewers[ it->second ].last_seen = now - 2 * timeout;
+            }
+        }
+        // Swap-and-pop the expired viewers.
+        for ( std::size_t i = 0; i < m_viewers.size ( ); ) {
+            if ( now - m_viewers[ i ].last_seen > timeout ) {
+                m_index.erase ( key ( m_viewers[ i ].address, m_viewers[ i ].port ) );
+                if ( i != m_viewers.size ( ) - 1u ) {
+                    m_viewers[ i ] = m_viewers.back ( );
+                    m_index[ key ( m_viewers[ i ].address, m_viewers[ i ].port ) ] = i;
+                }
+                m_viewers.pop_back ( );
+            }
+            else {
+                ++i;
+            }
+        }
+        m_viewer_count.store ( m_viewers.size ( ), std::memory_order_relaxed );
+    }
+
+    sf::UdpSocket m_socket;
+    std::thread m_thread;
+    std::atomic<bool> m_running = false;
+    std::atomic<std::size_t> m_viewer_count = 0u;
+
+    std::mutex m_mutex;
+    std::condition_variable m_has_snapshot;
+    Snapshot m_mailbox;
+    bool m_has_mailbox = false;
+
+    // Owned by the fan-out thread.
+    std::vector<Viewer> m_viewers;
+    std::unordered_map<std::uint64_t, std::size_t> m_index;
+    // Receiving into a smaller buffer fails (on windows) on a larger datagram.
+    std::array<std::uint8_t, sf::UdpSocket::MaxDatagramSize> m_datagram;
+};
+
+// Synthetic viewers, for load testing a server (over loopback): viewers_ sockets subscribe, receive and decode for
+// seconds_, then report what arrived.
+inline int generate_viewer_load ( const sf::IpAddress & server_, const unsigned short port_, const std::size_t viewers_,
+                                  const std::int32_t seconds_ ) {
+    struct Viewer {
+        std::unique_ptr<sf::UdpSocket> socket;
+        Snapshot key, last;
+        std::uint64_t received = 0u, rejected = 0u, missed = 0u;
+    };
+    using Clock = std::chrono::steady_clock;
+    std::vector<Viewer> viewers ( viewers_ );
+    for ( Viewer & viewer : viewers ) {
+        viewer.socket = std::make_unique<sf::UdpSocket> ( );
+        viewer.socket->bind ( sf::Socket::AnyPort );
+        viewer.socket->setBlocking ( false );
+        viewer.key.tick = viewer.last.tick = ~0u;
+    }
+    const std::uint8_t hello = ( std::uint8_t ) Message::Hello, bye = ( std::uint8_t ) Message::Bye;
+    const Clock::time_point start = Clock::now ( ), end = start + std::chrono::seconds ( seconds_ );
+    // The hellos are spread over the second, a burst of them overflows the server's receive buffer (and then the same
+    // viewers lose every round).
+    std::uint64_t hellos = 0u;
+    Codec::Packet packet;
+    std::size_t size;
+    sf::IpAddress address;
+    unsigned short port;
+    while ( Clock::now ( ) < end ) {
+        const std::uint64_t due = 1u + ( Clock::now ( ) - start ) * viewers_ / std::chrono::seconds ( 1 );
+        for ( ; hellos < due; ++hellos ) {
+            viewers[ hellos % viewers_ ].socket->send ( &hello, 1u, server_, port_ );
+        }
+        bool idle = true;
+        for ( Viewer & viewer : viewers ) {
+            while ( sf::Socket::Done == viewer.socket->receive ( packet.data ( ), packet.size ( ), size, address, port ) ) {
+                idle = false;
+                Snapshot snapshot;
+                if ( not Codec::decode ( packet.data ( ), size, viewer.key, snapshot ) ) {
+                    ++viewer.rejected;
+                    continue;
+                }
+                if ( ~0u != viewer.last.tick and snapshot.tick > viewer.last.tick + 1u ) {
+                    viewer.missed += snapshot.tick - viewer.last.tick - 1u;
+                }
+                ++viewer.received;
+                viewer.last = snapshot;
+            }
+        }
+        if ( idle ) {
+            std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+        }
+    }
+    std::uint64_t received = 0u, rejected = 0u, missed = 0u, starved = 0u;
+    for ( Viewer & viewer : viewers ) {
+        viewer.socket->send ( &bye, 1u, server_, port_ );
+        received += viewer.received, rejected += viewer.rejected, missed += viewer.missed;
+        starved += 0u == viewer.received;
+    }
+    std::cout << viewers_ << " viewers, " << seconds_ << " s: " << received << " frames received ("
+              << ( double ) received / ( ( double ) viewers_ * seconds_ ) << " per viewer per second), " << missed << " missed, "
+              << rejected << " rejected (waiting for a key frame), " << starved << " viewers received nothing." << std::endl;
+    return 0u == starved ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+} // namespace pong::broadcast
@@ -0,0 +1,231 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "game.hpp"
+#include "random.hpp"
+
+// A paddle controlled by a (reinforcement learning) agent, the action holds for a step of the environment.
+struct AgentController {
+
+    enum Action : std::int32_t { Stay = 0, Up = 1, Down = 2 };
+
+    std::int32_t m_action = Stay;
+
+    void create ( sf::RenderWindowPtr, const sf::Int32, const pong::RandomStream & ) noexcept {}
+
+    template<pong::Side S>
+    float next_y ( const sf::Point & paddle_position_, const Ball & ) noexcept {
+        constexpr float max_step = 9.0f; // As the ai's.
+        const float step         = Up == m_action ? -max_step : Down == m_action ? max_step : 0.0f;
+        return std::clamp ( paddle_position_.y + step, pong::geometry::paddle_min_y, pong::geometry::paddle_max_y );
+    }
+};
+
+// A batch of independent matches for training agents (gym-style), the agents play the right paddle against the
+// heuristic ai. All buffers are the caller's and laid out contiguously by environment: observations observation_size
+// floats per environment, actions (AgentController::Action), rewards and dones one per environment. A step repeats
+// the action for frame_skip frames, the reward is the points the agent won minus the points it lost in those frames.
+// An environment whose match is won is done and reset at once (the observation is the first of the next match). The
+// environments are split over a pool of threads (the calling thread included), stepping doesn't allocate.
+class Environments {
+
+    public:
+    using AgentPaddle = Paddle<pong::Side::Right, AgentController>;
+    using Game        = Match<ComputerPaddle, AgentPaddle>;
+
+    // Ball x, y, velocity x, y (in serve speeds), agent paddle y, ai paddle y (all positions in [ -1, 1 ]), 1 while
+    // the ball waits to be served, else 0, and the score difference (over 11).
+    static constexpr std::size_t observation_size = 8u;
+
+    Environments ( const std::size_t size_, const std::size_t frame_skip_ = 4u, const std::size_t threads_ = 1u ) :
+        m_frame_skip ( std::max<std::size_t> ( 1u, frame_skip_ ) ),
+        m_threads ( std::clamp<std::size_t> ( threads_, 1u, std::max<std::size_t> ( 1u, size_ ) ) ),
+        m_episodes ( size_, 0u ) {
+        m_games.reserve ( size_ );
+        for ( std::size_t i = 0; i < size_; ++i ) {
+            m_games.emplace_back ( pong::RandomStreams ( 0u ) );
+        }
+        m_workers.reserve ( m_threads - 1u );
+        for ( std::size_t t = 1; t < m_threads; ++t ) {
+            m_workers.emplace_back ( [ this, t ] { work ( t ); } );
+        }
+    }
+
+    Environments ( const Environments & ) = delete;
+
+    ~Environments ( ) {
+        {
+            std::lock_guard<std::mutex> lock ( m_mutex );
+            m_stop = true;
+        }
+        m_wake.notify_all ( );
+        for ( std::thread & worker : m_workers ) {
+            worker.join ( );
+        }
+    }
+
+    [[nodiscard]] std::size_t size ( ) const noexcept { return m_games.size ( ); }
+    // The threads stepping (the calling one included), as requested, but at least 1 and at most one per environment.
+    [[nodiscard]] std::size_t threads ( ) const noexcept { return m_threads; }
+
+    // Starts a new match in every environment (do so before the first step), the matches derive from seed_ (and the index
+    // of the environment).
+    void reset ( const std::uint64_t seed_, float * const observations_ ) {
+        m_seed = seed_;
+        std::fill ( m_episodes.begin ( ), m_episodes.end ( ), 0u );
+        m_observations = observations_;
+        dispatch ( &Environments::reset_range );
+    }
+
+    void step ( const std::int32_t * const actions_, float * const observations_, float * const rewards_,
+                std::uint8_t * const dones_ ) {
+        m_actions = actions_, m_observations = observations_, m_rewards = rewards_, m_dones = dones_;
+        dispatch ( &Environments::step_range );
+    }
+
+    private:
+    using Job = void ( Environments::* ) ( std::size_t, std::size_t );
+
+    void dispatch ( const Job job_ ) {
+        m_job = job_;
+        if ( m_workers.empty ( ) ) {
+            run ( 0u );
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock ( m_mutex );
+            ++m_generation, m_running = m_workers.size ( );
+        }
+        m_wake.notify_all ( );
+        run ( 0u );
+        std::unique_lock<std::mutex> lock ( m_mutex );
+        m_finished.wait ( lock, [ this ] { return not m_running; } );
+    }
+
+    // A worker runs its share of every job (once per generation), until stopped.
+    void work ( const std::size_t thread_ ) {
+        std::uint64_t generation = 0u;
+        for ( ;; ) {
+            {
+                std::unique_lock<std::mutex> lock ( m_mutex );
+                m_wake.wait ( lock, [ this, generation ] { return m_stop or generation != m_generation; } );
+                if ( m_stop ) {
+                    return;
+                }
+                generation = m_generation;
+            }
+            run ( thread_ );
+            std::unique_lock<std::mutex> lock ( m_mutex );
+            if ( not --m_running ) {
+                lock.unlock ( );
+                m_finished.notify_one ( );
+            }
+        }
+    }
+
+    void run ( const std::size_t thread_ ) {
+        ( this->*m_job ) ( thread_ * size ( ) / m_threads, ( thread_ + 1u ) * size ( ) / m_threads );
+    }
+
+    void reset_range ( const std::size_t begin_, const std::size_t end_ ) {
+        for ( std::size_t i = begin_; i < end_; ++i ) {
+            restart ( i );
+        }
+    }
+
+    void step_range ( const std::size_t begin_, const std::size_t end_ ) {
+        for ( std::size_t i = begin_; i < end_; ++i ) {
+            Game & game                               = m_games[ i ];
+            game.m_right_paddle.m_controller.m_action = m_actions[ i ];
+            const Score before                        = game.m_score;
+            for ( std::size_t f = 0; f < m_frame_skip and not game.m_score.has_won ( ); ++f ) {
+                game.step ( );
+            }
+            m_rewards[ i ] = ( float ) ( ( game.m_score.m_right - before.m_right ) - ( game.m_score.m_left - before.m_left ) );
+            m_dones[ i ]   = game.m_score.has_won ( );
+            if ( m_dones[ i ] ) {
+                ++m_episodes[ i ];
+                restart ( i );
+            }
+            else {
+                observe ( game, m_observations + i * observation_size );
+            }
+        }
+    }
+
+    void restart ( const std::size_t i_ ) {
+        const pong::RandomStreams random_streams (
+            pong::splitmix64 ( m_seed ^ pong::splitmix64 ( ( ( std::uint64_t ) i_ << 32 ) | m_episodes[ i_ ] ) ) );
+        m_games[ i_ ].reset ( nullptr, 0, random_streams );
+        observe ( m_games[ i_ ], m_observations + i_ * observation_size );
+    }
+
+    static void observe ( const Game & game_, float * const observation_ ) noexcept {
+        using namespace pong::geometry;
+        constexpr float centre_x = 0.5f * ( table_left + table_right ), half_width = 0.5f * ( table_right - table_left );
+        constexpr float centre_y = 0.5f * ( table_top + table_bottom ), half_height = 0.5f * table_height;
+        constexpr float paddle_y = 0.5f * ( paddle_min_y + paddle_max_y ), paddle_range = 0.5f * ( paddle_max_y - paddle_min_y );
+        const Ball & ball        = game_.m_ball;
+        const sf::Point position = ball.m_shape.getPosition ( );
+        const float speed        = ball.m_speed / 10.0f; // The serve speed.
+        observation_[ 0 ]        = ( position.x - centre_x ) / half_width;
+        observation_[ 1 ]        = ( position.y - centre_y ) / half_height;
+        observation_[ 2 ]        = speed * std::sin ( ball.m_angle );
+        observation_[ 3 ]        = speed * std::cos ( ball.m_angle );
+        observation_[ 4 ]        = ( game_.m_right_paddle.m_shape.getPosition ( ).y - paddle_y ) / paddle_range;
+        observation_[ 5 ]        = ( game_.m_left_paddle.m_shape.getPosition ( ).y - paddle_y ) / paddle_range;
+        observation_[ 6 ]        = ( float ) not game_.is_awake ( Game::Entity::Ball );
+        observation_[ 7 ]        = ( float ) ( game_.m_score.m_right - game_.m_score.m_left ) / 11.0f;
+    }
+
+    std::size_t m_frame_skip, m_threads;
+    std::vector<Game> m_games;
+    std::vector<std::uint64_t> m_episodes;
+    std::uint64_t m_seed = 0u;
+
+    // The job at hand.
+    Job m_job                      = nullptr;
+    const std::int32_t * m_actions = nullptr;
+    float *m_observations = nullptr, *m_rewards = nullptr;
+    std::uint8_t * m_dones = nullptr;
+
+    // The pool, a job is started by bumping the generation and done when no worker is running it anymore.
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_finished;
+    std::uint64_t m_generation = 0u;
+    std::size_t m_running      = 0u;
+    bool m_stop                = false;
+    std::vector<std::thread> m_workers;
+};
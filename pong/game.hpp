@@ -0,0 +1,539 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <SFML/Extensions.hpp>
+#include <SFML/Graphics.hpp>
+
+#include "random.hpp"
+#include "slot_map.hpp"
+#include "timer_wheel.hpp"
+
+// The game logic: the table, the ball, the paddles and their controllers (but the player's) and the rules of a match.
+// Nothing here needs a window, the app, the exporter and the training environments all play the same game.
+
+/*
+                        C3-----------------------------------N-----------------------------------C0
+                        |                                                                         |
+                        |                                                                         |
+                        |                                                                         |
+                        |                                                                         |
+                        |                                                                         |
+                        |                                                                         |
+                        |                                                                         |
+                        |                                                                         |
+                        |           0.0 pi / 2.0 pi                                               |
+                        W                  |                                                      E
+                        |          Q3      |      Q0                                              |
+                        |                  |                                                      |
+                        |   1.5 pi -------Pos------- 0.5 pi                                       |
+                        |                  |                                                      |
+                        |          Q2      |      Q1                                              |
+                        |                  |                                                      |
+                        |                1.0 pi                                                   |
+                        |                                                                         |
+                        |                                                                         |
+                        |                                                                         |
+                        C2-----------------------------------S-----------------------------------C1
+*/
+
+namespace pong {
+
+inline bool equal ( const float a_, const float b_ ) noexcept { return std::abs ( b_ - a_ ) < 4.0f * FLT_EPSILON; }
+inline bool not_equal ( const float a_, const float b_ ) noexcept { return std::abs ( b_ - a_ ) >= 4.0f * FLT_EPSILON; }
+
+// Round to the nearest odd integral value, up or down (the default) iff even. A constexpr stand-in for sf::makeOdd, for
+// the (positive) geometry constants only, rounding is towards zero for negative values.
+[[nodiscard]] constexpr float make_odd ( const float v_, const bool up_ = false ) noexcept {
+    const sf::Int32 i = ( sf::Int32 ) ( v_ + 0.5f );
+    return ( float ) ( ( i & 1 ) ? i : ( up_ ? i + 1 : i - 1 ) );
+}
+
+enum class Side : sf::Int32 { Left = 0, Right = 1 };
+
+// Everything about the table (and what's on it) is fixed at compile time, the window is never resized.
+
+namespace geometry {
+
+// Steps per second of a simulation that doesn't show on a display (export, training), so it plays out the same on any
+// machine. The game itself steps once per displayed frame.
+constexpr sf::Int32 tick_rate = 60;
+
+constexpr sf::Int32 window_width = 1'200, window_height = 900;
+
+constexpr float rim_size = 100.0f, shadow_offset = -5.0f;
+
+constexpr float table_left   = rim_size + shadow_offset;
+constexpr float table_top    = rim_size + shadow_offset;
+constexpr float table_right  = ( float ) window_width - rim_size + shadow_offset;
+constexpr float table_bottom = ( float ) window_height - rim_size + shadow_offset;
+constexpr float table_height = table_bottom - table_top;
+
+constexpr float ball_size = make_odd ( 15.0f );
+
+constexpr float paddle_width             = make_odd ( 11.0f );
+constexpr float paddle_length            = make_odd ( 6.0f * paddle_width );
+constexpr float paddle_detector_length   = paddle_length + ball_size;
+constexpr float paddle_detector_offset_y = -0.5f * ( paddle_length + ball_size );
+constexpr float paddle_rim_offset        = 61.0f;
+constexpr float paddle_min_y             = table_top + 0.075f * table_height;
+constexpr float paddle_max_y             = table_bottom - 0.075f * table_height;
+constexpr float paddle_mouse_ratio       = 0.4125f;
+constexpr sf::Int32 paddle_sectors       = 15;
+
+static_assert ( paddle_sectors & 1, "the number of paddle sectors has to be odd, the middle one returns the ball straight" );
+static_assert ( ( sf::Int32 ) paddle_width & 1 and ( sf::Int32 ) paddle_length & 1 and ( sf::Int32 ) ball_size & 1,
+                "objects have to be odd-sized, so they can be centred on a pixel" );
+static_assert ( paddle_min_y < paddle_max_y );
+
+// Centre of the paddle, left paddle rounds down, right paddle rounds up.
+template<Side S>
+constexpr float paddle_x = Side::Left == S ? make_odd ( table_left + paddle_rim_offset, false )
+                                           : make_odd ( table_right - paddle_rim_offset, true );
+// Offset of the detector w.r.t. the centre of the paddle, it sits on the table side of the paddle.
+template<Side S>
+constexpr float paddle_detector_offset_x = ( Side::Left == S ? 0.5f : -0.5f ) * ( ball_size + paddle_width );
+
+static_assert ( paddle_x<Side::Left> < paddle_x<Side::Right> );
+
+inline sf::FloatBox table_box ( ) noexcept { return sf::FloatBox ( table_left, table_top, table_right, table_bottom ); }
+} // namespace geometry
+} // namespace pong
+
+struct Score {
+
+    sf::Int32 m_left, m_right;
+
+    Score ( ) noexcept : m_left ( 0 ), m_right ( 0 ) {}
+
+    void reset ( ) noexcept { m_left = 0, m_right = 0; }
+
+    bool has_won ( ) const noexcept { return m_left > 10 or m_right > 10; }
+};
+
+struct Ball {
+
+    enum class Direction : sf::Int32 { MovesToRight = 0, MovesToLeft = 1 };
+    enum class Event : sf::Int32 { None = 0, HitWall = 1, Missed = 2 };
+
+    pong::RandomStream m_random;
+    sf::SquareShape m_shape;
+    float m_angle, m_speed_increment, m_speed;
+    sf::Point m_min, m_max;
+    Direction m_direction;
+    sf::Point m_previous_position;
+
+    // The ball moves once per tick, at tick_rate_ ticks per second.
+    Ball ( const float size_, const pong::RandomStream & random_, const sf::Int32 tick_rate_ ) :
+        m_shape ( sf::makeOdd ( size_ ) ), m_speed_increment ( 60.0f / ( float ) tick_rate_ ) {
+        reset ( random_ );
+    }
+
+    // A new ball drawing from random_, as constructed (create ( ) positions it).
+    void reset ( const pong::RandomStream & random_ ) noexcept {
+        m_random            = random_;
+        m_angle             = m_random.uniform ( 0.333f * sf::pi, 0.666f * sf::pi );
+        m_speed             = 10.0f * m_speed_increment;
+        m_direction         = ( Direction ) ( m_angle / sf::pi );
+        m_previous_position = { };
+    }
+
+    void create ( const sf::FloatBox & m_table_box_ ) noexcept {
+        const float half_ball_size = 0.5 * m_shape.getSize ( ).x;
+        m_min = { m_table_box_.left + half_ball_size, m_table_box_.top + half_ball_size },
+        m_max = { m_table_box_.right - half_ball_size, m_table_box_.bottom - half_ball_size };
+        m_shape.setFillColor ( sf::Color ( 0xE1, 0xE1, 0xE1 ) );
+        sf::centreOrigin ( m_shape );
+        m_shape.setPosition ( m_random.uniform ( m_min.x, m_max.x ), m_random.uniform ( m_min.y, m_max.y ) );
+    }
+
+    void new_ball ( sf::Point & position_ ) noexcept {
+        const bool coin_toss = m_random.bernoulli ( );
+        if ( m_direction == Direction::MovesToLeft ) {
+            m_angle = coin_toss ? m_random.uniform ( 1.22f * sf::pi, 1.33f * sf::pi )
+                                : m_random.uniform ( 1.66f * sf::pi, 1.78f * sf::pi );
+        }
+        else {
+            m_angle = coin_toss ? m_random.uniform ( 0.66f * sf::pi, 0.78f * sf::pi )
+                                : m_random.uniform ( 0.22f * sf::pi, 0.33f * sf::pi );
+        }
+        position_ = { ( m_max.x - m_min.x ) * 0.5f + m_min.x,
+                      ( m_max.y - m_min.y ) * ( 0.1f + ( float ) coin_toss * 0.8f ) + m_min.y };
+        m_speed = 10.0f;
+    }
+
+    Event update ( Score & score_ ) noexcept {
+        Event event = Event::None;
+        m_previous_position    = m_shape.getPosition ( );
+        sf::Point new_position = m_previous_position + m_speed * sf::Force ( std::sin ( m_angle ), std::cos ( m_angle ) );
+        if ( new_position.x < m_min.x or new_position.x > m_max.x ) {
+            score_.m_right += new_position.x < m_min.x;
+            score_.m_left += new_position.x > m_max.x;
+            event = Event::Missed;
+            new_ball ( new_position );
+        }
+        if ( new_position.y < m_min.y or new_position.y > m_max.y ) {
+            m_angle        = sf::clampRadians ( sf::pi - m_angle + m_random.normal ( 0.0f, 0.0125f ) );
+            m_direction    = ( Direction ) ( m_angle / sf::pi );
+            new_position.y = new_position.y < m_min.y ? m_min.y : m_max.y;
+            event          = Event::HitWall;
+        }
+        m_shape.setPosition ( new_position );
+        return event;
+    }
+};
+
+// Paddle controllers, they decide where the paddle (centre) wants to be this frame. The player's controller
+// (the mouse) is the app's.
+
+struct HeuristicController {
+
+    pong::RandomStream m_random;
+
+    void create ( sf::RenderWindowPtr, const sf::Int32, const pong::RandomStream & random_ ) noexcept { m_random = random_; }
+
+    template<pong::Side S>
+    float next_y ( const sf::Point & paddle_position_, const Ball & ball_ ) noexcept {
+        using namespace pong::geometry;
+        constexpr Ball::Direction towards = pong::Side::Left == S ? Ball::Direction::MovesToLeft : Ball::Direction::MovesToRight;
+        const sf::Point ball_position ( ball_.m_shape.getPosition ( ) );
+        if ( is_y_in_paddle ( paddle_position_.y, ball_position.y ) ) {
+            return paddle_position_.y;
+        }
+        if ( ( towards == ball_.m_direction ? ball_position.y : ( paddle_min_y + paddle_max_y ) / 2.0f ) < paddle_position_.y ) {
+            const float new_paddle_position_y =
+                sf::makeOdd ( paddle_position_.y - 9.0f + 9.0f * m_random.uniform ( -7.0f / 15.0f, 7.0f / 15.0f ), false );
+            if ( new_paddle_position_y > paddle_min_y and ball_position.y < new_paddle_position_y ) {
+                return new_paddle_position_y;
+            }
+        }
+        else {
+            const float new_paddle_position_y =
+                sf::makeOdd ( paddle_position_.y + 9.0f + 9.0f * m_random.uniform ( -7.0f / 15.0f, 7.0f / 15.0f ), true );
+            if ( new_paddle_position_y < paddle_max_y and ball_position.y > new_paddle_position_y ) {
+                return new_paddle_position_y;
+            }
+        }
+        return paddle_position_.y;
+    }
+
+    private:
+    static constexpr bool is_y_in_paddle ( const float paddle_centre_y_, const float y_ ) noexcept {
+        // Does the value of y fall into the range of the paddle?
+        return y_ > ( paddle_centre_y_ - 0.4f * pong::geometry::paddle_length ) and
+               y_ < ( paddle_centre_y_ + 0.4f * pong::geometry::paddle_length );
+    }
+};
+
+// Extrapolates the trajectory of the ball (bouncing off the walls) to where it will cross the paddle and moves there
+// at the same maximum speed as the heuristic controller.
+struct PredictiveController {
+
+    void create ( sf::RenderWindowPtr, const sf::Int32, const pong::RandomStream & ) noexcept {}
+
+    template<pong::Side S>
+    float next_y ( const sf::Point & paddle_position_, const Ball & ball_ ) noexcept {
+        using namespace pong::geometry;
+        constexpr Ball::Direction towards = pong::Side::Left == S ? Ball::Direction::MovesToLeft : Ball::Direction::MovesToRight;
+        constexpr float max_step = 9.0f;
+        float target_y = ( paddle_min_y + paddle_max_y ) / 2.0f;
+        if ( towards == ball_.m_direction ) {
+            const sf::Point ball_position ( ball_.m_shape.getPosition ( ) );
+            const float dx = std::sin ( ball_.m_angle );
+            if ( pong::not_equal ( 0.0f, dx ) ) {
+                const float y = ball_position.y + std::cos ( ball_.m_angle ) * ( paddle_x<S> - ball_position.x ) / dx;
+                // Fold y back into the range of the ball, every wall hit mirrors the trajectory.
+                const float range = ball_.m_max.y - ball_.m_min.y;
+                float folded      = std::fmod ( std::abs ( y - ball_.m_min.y ), 2.0f * range );
+                if ( folded > range ) {
+                    folded = 2.0f * range - folded;
+                }
+                target_y = ball_.m_min.y + folded;
+            }
+        }
+        return std::clamp ( paddle_position_.y + std::clamp ( target_y - paddle_position_.y, -max_step, max_step ), paddle_min_y,
+                            paddle_max_y );
+    }
+};
+
+// Replays a script, one paddle (centre) y per frame, the last one is held.
+struct ScriptedController {
+
+    const std::vector<float> * m_script = nullptr;
+    std::size_t m_frame                 = 0u;
+
+    void create ( sf::RenderWindowPtr, const sf::Int32, const pong::RandomStream & ) noexcept {}
+
+    template<pong::Side S>
+    float next_y ( const sf::Point & paddle_position_, const Ball & ) noexcept {
+        if ( not m_script or m_script->empty ( ) ) {
+            return paddle_position_.y;
+        }
+        const float y = ( *m_script )[ std::min ( m_frame++, m_script->size ( ) - 1u ) ];
+        return std::clamp ( y, pong::geometry::paddle_min_y, pong::geometry::paddle_max_y );
+    }
+};
+
+template<pong::Side S, typename Controller>
+struct Paddle {
+
+    static constexpr pong::Side side = S;
+    // Ball direction that brings the ball to this paddle.
+    static constexpr Ball::Direction towards = pong::Side::Left == S ? Ball::Direction::MovesToLeft : Ball::Direction::MovesToRight;
+
+    Controller m_controller;
+    sf::RectangleShape m_shape;
+
+    Paddle ( ) : m_shape ( sf::Vector2f{ pong::geometry::paddle_width, pong::geometry::paddle_length } ) {}
+
+    // The window is only used by the player controller, it can be nullptr otherwise.
+    void create ( sf::RenderWindowPtr rwp_, const sf::Int32 desktop_height_, const pong::RandomStream & random_ ) noexcept {
+        m_controller.create ( rwp_, desktop_height_, random_ );
+        m_shape.setFillColor ( sf::Color ( 0xCB, 0xCB, 0xCB ) );
+        sf::centreOrigin ( m_shape );
+        m_shape.setPosition ( pong::geometry::paddle_x<S>, pong::geometry::window_height / 2.0f );
+    }
+
+    // Update and return true iff paddle hits the ball.
+    bool update ( Ball & ball_ ) noexcept {
+        sf::Point ball_position ( ball_.m_shape.getPosition ( ) );
+        sf::Point paddle_position ( pong::geometry::paddle_x<S>,
+                                    m_controller.template next_y<S> ( m_shape.getPosition ( ), ball_ ) );
+        return update ( ball_, ball_position, paddle_position );
+    }
+
+    private:
+    bool update ( Ball & ball_, sf::Point & ball_position_, sf::Point & paddle_position_ ) noexcept {
+        m_shape.setPosition ( paddle_position_ );
+        paddle_position_ += sf::Vector2f{ pong::geometry::paddle_detector_offset_x<S>, pong::geometry::paddle_detector_offset_y };
+
+        // Weed out all the positions that are guaranteed not to hit the paddle.
+
+        if ( towards != ball_.m_direction ) {
+            return false;
+        }
+        if constexpr ( pong::Side::Left == S ) {
+            if ( ball_position_.x > paddle_position_.x or ball_.m_previous_position.x < paddle_position_.x ) {
+                return false;
+            }
+        }
+        else {
+            if ( ball_position_.x < paddle_position_.x or ball_.m_previous_position.x > paddle_position_.x ) {
+                return false;
+            }
+        }
+
+        // Could have intersect...
+
+        sf::Point intersection = ball_position_ - ball_.m_previous_position;
+
+        if ( pong::not_equal ( 0.0f, intersection.x ) ) { // Not vertical (slope (s) is inf).
+            const float s = intersection.y / intersection.x;
+            // y = s * x + b
+            intersection.y = s * ( paddle_position_.x - ball_position_.x ) + ball_position_.y;
+            if ( intersection.y >= paddle_position_.y and
+                 intersection.y <= ( paddle_position_.y + pong::geometry::paddle_detector_length ) ) {
+                intersection.x = paddle_position_.x;
+                return_ball ( ball_, intersection,
+                              ( ball_position_.x - ball_.m_previous_position.x ) /
+                                  ( ball_position_.x - ball_.m_previous_position.x ) );
+                return true;
+            }
+            return false;
+        }
+
+        else { // Vertical: detector and ball trajectory are colinear with overlap.
+            intersection = paddle_position_; // Select top of detector (assume ball comes from top).
+            if ( ball_.m_previous_position.y > paddle_position_.y ) {
+                // If the ball comes from below, switch to the bottom of the detector.
+                intersection.y += pong::geometry::paddle_detector_length;
+            }
+            return_ball ( ball_, intersection,
+                          1.0f - ( intersection.x - ball_.m_previous_position.x ) /
+                                     ( ball_position_.x - ball_.m_previous_position.x ) );
+            return true;
+        }
+    }
+
+    void return_ball ( Ball & ball_, const sf::Point & intersection_, const float ratio_ ) const noexcept {
+        constexpr float epsilon           = 0.01f * sf::pi;
+        constexpr float sector_sign       = pong::Side::Right == S ? 0.075f : -0.075f;
+        constexpr float zero_pi_or_one_pi = ( float ) ( Ball::Direction::MovesToRight == towards ) * sf::pi;
+        float angle                       = sf::half_pi + zero_pi_or_one_pi;
+        angle += sector_sign * sector_hit ( ball_ );
+        angle += ball_.m_random.normal ( 0.0f, 0.025f );
+        ball_.m_angle     = std::clamp ( angle, zero_pi_or_one_pi + epsilon, sf::pi + zero_pi_or_one_pi - epsilon );
+        ball_.m_direction = ( Ball::Direction ) ( ball_.m_angle / sf::pi );
+        // Set x-value of the ball so that it won't surpass the paddle on the wrong side.
+        ball_.m_speed += ball_.m_speed_increment;
+        ball_.m_shape.setPosition ( intersection_ +
+                                    ball_.m_speed * ratio_ * sf::Force ( std::sin ( ball_.m_angle ), std::cos ( ball_.m_angle ) ) );
+    }
+
+    float sector_hit ( const Ball & ball_ ) const noexcept {
+        using namespace pong::geometry;
+        const float top = m_shape.getPosition ( ).y - 0.5f * paddle_length;
+        return std::clamp ( ( ball_.m_shape.getPosition ( ).y - top ) / paddle_length, 0.0f, 0.999f ) * paddle_sectors -
+               ( float ) ( paddle_sectors / 2 );
+    }
+};
+
+using ComputerPaddle = Paddle<pong::Side::Left, HeuristicController>;
+
+// The rules of the game, independent of windows, sound and drawing.
+//
+// Waiting (to serve, to react) is sleeping, a sleeping entity isn't updated at all, the timer wheel wakes it up at the
+// exact time. What follows a point, a return and a won match is declared below, as sequences of cues.
+template<typename LeftPaddle, typename RightPaddle>
+struct Match {
+
+    struct Events {
+        Ball::Event ball       = Ball::Event::None;
+        bool hit_paddle        = false;
+        pong::Side paddle_side = pong::Side::Left; // The paddle that hit, iff hit_paddle.
+    };
+
+    // Left and Right are the paddles. The score sleeps after a won match, it resets when it wakes up.
+    enum class Entity : std::uint32_t { Ball, Left, Right, Score, EntityCount };
+
+    // Puts an entity to sleep for a while (from the moment the sequence starts), a sleep replaces the one it's in.
+    struct Cue {
+        Entity entity;
+        float microseconds;
+    };
+
+    // The ball is served after a pause, the ai gets a late start.
+    static constexpr std::array<Cue, 1> serve_to_right = { { { Entity::Ball, 500'000.0f } } };
+    static constexpr std::array<Cue, 2> serve_to_left  = {
+        { { Entity::Ball, 500'000.0f }, { Entity::Left, 500'000.0f + 333'333.3f / 2.0f } }
+    };
+    // The opponent reacts to a return.
+    static constexpr std::array<Cue, 1> left_returned  = { { { Entity::Right, 333'333.3f } } };
+    static constexpr std::array<Cue, 1> right_returned = { { { Entity::Left, 333'333.3f } } };
+    // The final score shows for a while, then the next match is served.
+    static constexpr std::array<Cue, 2> won = { { { Entity::Ball, 2'000'000.0f }, { Entity::Score, 2'000'000.0f } } };
+
+    Ball m_ball;
+    LeftPaddle m_left_paddle;
+    RightPaddle m_right_paddle;
+    Score m_score;
+
+    // A step ( ) is a tick, at tick_rate_ ticks per second.
+    explicit Match ( const pong::RandomStreams & random_streams_, const sf::Int32 tick_rate_ = pong::geometry::tick_rate ) :
+        m_ball ( pong::geometry::ball_size, random_streams_.stream ( pong::RandomStreams::Entity::Ball ), tick_rate_ ),
+        m_frame_duration ( 1'000'000.0 / tick_rate_ ) {
+        m_timers.reserve ( 2u * ( std::size_t ) Entity::EntityCount );
+    }
+
+    // The window is only needed for a player controlled paddle.
+    void create ( sf::RenderWindowPtr rwp_, const sf::Int32 desktop_height_,
+                  const pong::RandomStreams & random_streams_ ) noexcept {
+        m_ball.create ( pong::geometry::table_box ( ) );
+        m_left_paddle.create ( rwp_, desktop_height_, random_streams_.stream ( pong::RandomStreams::Entity::LeftPaddle ) );
+        m_right_paddle.create ( rwp_, desktop_height_, random_streams_.stream ( pong::RandomStreams::Entity::RightPaddle ) );
+    }
+
+    // Starts over, as constructed from random_streams_ and created, in place (nothing allocates).
+    void reset ( sf::RenderWindowPtr rwp_, const sf::Int32 desktop_height_,
+                 const pong::RandomStreams & random_streams_ ) noexcept {
+        m_timers.clear ( );
+        m_time = 0.0;
+        m_score.reset ( );
+        m_ball.reset ( random_streams_.stream ( pong::RandomStreams::Entity::Ball ) );
+        create ( rwp_, desktop_height_, random_streams_ );
+    }
+
+    [[nodiscard]] bool is_awake ( const Entity entity_ ) const noexcept {
+        return not m_timers.is_pending ( m_wake_ups[ ( std::size_t ) entity_ ] );
+    }
+
+    // Microseconds until the entity wakes up, 0 if it's awake.
+    [[nodiscard]] float wakes_in ( const Entity entity_ ) const noexcept {
+        return ( float ) ( m_timers.due ( m_wake_ups[ ( std::size_t ) entity_ ] ) - m_timers.now ( ) );
+    }
+
+    // Time passed without stepping (while idling), wakes up whoever is due.
+    void elapse ( const float microseconds_ ) noexcept { advance ( microseconds_ ); }
+
+    // Advances the match by one frame.
+    Events step ( ) noexcept {
+        advance ( m_frame_duration );
+        Events events;
+        if ( is_awake ( Entity::Ball ) ) {
+            events.ball = m_ball.update ( m_score );
+            if ( Ball::Event::Missed == events.ball ) {
+                if ( m_score.has_won ( ) ) {
+                    play ( won );
+                }
+                else if ( Ball::Direction::MovesToLeft == m_ball.m_direction ) {
+                    play ( serve_to_left );
+                }
+                else {
+                    play ( serve_to_right );
+                }
+            }
+        }
+        if ( is_awake ( Entity::Right ) and m_right_paddle.update ( m_ball ) ) {
+            events.hit_paddle = true, events.paddle_side = pong::Side::Right;
+            play ( right_returned );
+        }
+        if ( is_awake ( Entity::Left ) and m_left_paddle.update ( m_ball ) ) {
+            events.hit_paddle = true, events.paddle_side = pong::Side::Left;
+            play ( left_returned );
+        }
+        return events;
+    }
+
+    private:
+    template<std::size_t N>
+    void play ( const std::array<Cue, N> & sequence_ ) noexcept {
+        for ( const Cue & cue : sequence_ ) {
+            pong::Handle & wake_up = m_wake_ups[ ( std::size_t ) cue.entity ];
+            m_timers.cancel ( wake_up );
+            wake_up = m_timers.schedule ( ( pong::TimerWheel::Time ) ( m_time + cue.microseconds ), ( std::uint32_t ) cue.entity );
+        }
+    }
+
+    void advance ( const double microseconds_ ) noexcept {
+        m_time += microseconds_;
+        m_timers.advance ( ( pong::TimerWheel::Time ) m_time, [ this ] ( const std::uint32_t entity_ ) {
+            if ( Entity::Score == ( Entity ) entity_ ) {
+                m_score.reset ( );
+            }
+        } );
+    }
+
+    double m_time = 0.0, m_frame_duration; // Microseconds.
+    pong::TimerWheel m_timers;
+    std::array<pong::Handle, ( std::size_t ) Entity::EntityCount> m_wake_ups;
+};
@@ -0,0 +1,96 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <thread>
+
+#if defined( _WIN32 )
+#    include <windows.h> // MsgWaitForMultipleObjectsEx.
+#endif
+
+namespace pong {
+
+// Decides how the main loop waits: Active frames are paced by vsync, Idle waits (nothing moves) block until the next
+// frame that changes something or until input arrives, Background waits (no focus) block for a long tick or until input
+// arrives. Counts the wakeups of the main thread, per mode.
+class IdleScheduler {
+
+    public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode : std::size_t { Active, Idle, Background, ModeCount };
+
+    IdleScheduler ( ) noexcept : m_start ( Clock::now ( ) ), m_last ( m_start ) {}
+
+    // Accounts for an active (vsync-paced) frame.
+    void tick ( ) noexcept { account ( Mode::Active ); }
+
+    // Blocks until timeout_ or until input arrives (for the calling thread, which owns the window), returns the time spent.
+    Clock::duration wait ( const Mode mode_, const Clock::duration timeout_ ) noexcept {
+        const Clock::time_point start = Clock::now ( );
+#if defined( _WIN32 )
+        const DWORD milliseconds = ( DWORD ) std::chrono::duration_cast<std::chrono::milliseconds> ( timeout_ ).count ( );
+        MsgWaitForMultipleObjectsEx ( 0u, nullptr, milliseconds, QS_ALLINPUT, MWMO_INPUTAVAILABLE );
+#else
+        std::this_thread::sleep_for ( timeout_ );
+#endif
+        account ( mode_ );
+        return Clock::now ( ) - start;
+    }
+
+    void report ( std::ostream & out_ ) const {
+        static constexpr const char * names[ ( std::size_t ) Mode::ModeCount ] = { "active", "idle", "background" };
+        const float total = std::chrono::duration<float> ( m_last - m_start ).count ( );
+        std::uint64_t wakeups = 0u;
+        for ( std::uint64_t w : m_wakeups ) {
+            wakeups += w;
+        }
+        out_ << "wakeups: " << ( total > 0.0f ? wakeups / total : 0.0f ) << " per second over " << total << " s";
+        for ( std::size_t m = 0; m < ( std::size_t ) Mode::ModeCount; ++m ) {
+            const float time = std::chrono::duration<float> ( m_time[ m ] ).count ( );
+            out_ << ", " << names[ m ] << " " << ( time > 0.0f ? m_wakeups[ m ] / time : 0.0f ) << "/s ("
+                 << ( total > 0.0f ? 100.0f * time / total : 0.0f ) << "%)";
+        }
+        out_ << '\n';
+    }
+
+    private:
+    void account ( const Mode mode_ ) noexcept {
+        const Clock::time_point now = Clock::now ( );
+        ++m_wakeups[ ( std::size_t ) mode_ ];
+        m_time[ ( std::size_t ) mode_ ] += now - m_last;
+        m_last = now;
+    }
+
+    Clock::time_point m_start, m_last;
+    std::array<std::uint64_t, ( std::size_t ) Mode::ModeCount> m_wakeups{ };
+    std::array<Clock::duration, ( std::size_t ) Mode::ModeCount> m_time{ };
+};
+} // namespace pong
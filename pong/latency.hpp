@@ -0,0 +1,81 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ostream>
+
+namespace pong {
+
+// Latency of a (mouse) input sample to the end of each stage of the frame it was used in, in microseconds. Keeps the
+// last capacity frames in fixed storage, recording doesn't allocate.
+class LatencyRecorder {
+
+    public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Stage : std::size_t { Updated, Rendered, Displayed, StageCount };
+
+    static constexpr std::size_t capacity = 4'096u;
+
+    void stamp ( const Stage stage_ ) noexcept { m_stages[ stage_ ] = Clock::now ( ); }
+
+    // Records the frame stamped so far, for an input sampled at sample_.
+    void record ( const Clock::time_point sample_ ) noexcept {
+        const std::size_t i = m_count++ % capacity;
+        for ( std::size_t s = 0; s < StageCount; ++s ) {
+            m_samples[ s ][ i ] = std::chrono::duration<float, std::micro> ( m_stages[ s ] - sample_ ).count ( );
+        }
+    }
+
+    std::size_t size ( ) const noexcept { return std::min ( m_count, capacity ); }
+
+    void report ( std::ostream & out_ ) const {
+        static constexpr const char * names[ StageCount ] = { "update", "render", "display" };
+        const std::size_t n                               = size ( );
+        if ( not n ) {
+            out_ << "latency: no input samples.\n";
+            return;
+        }
+        out_ << "input latency over " << n << " frames (us, p50 / p90 / p99 / max):\n";
+        std::array<float, capacity> sorted;
+        for ( std::size_t s = 0; s < StageCount; ++s ) {
+            std::copy_n ( m_samples[ s ].begin ( ), n, sorted.begin ( ) );
+            std::sort ( sorted.begin ( ), sorted.begin ( ) + n );
+            auto percentile = [ & ] ( const float p_ ) { return sorted[ std::min ( n - 1u, ( std::size_t ) ( p_ * n ) ) ]; };
+            out_ << "    to end of " << names[ s ] << ": " << percentile ( 0.5f ) << " / " << percentile ( 0.9f ) << " / "
+                 << percentile ( 0.99f ) << " / " << sorted[ n - 1u ] << '\n';
+        }
+    }
+
+    private:
+    std::array<Clock::time_point, StageCount> m_stages;
+    std::array<std::array<float, capacity>, StageCount> m_samples;
+    std::size_t m_count = 0u;
+};
+} // namespace pong
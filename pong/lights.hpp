@@ -0,0 +1,201 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+#include "slot_map.hpp"
+
+namespace pong {
+
+// Additive (glow) lights. Static lights are baked into a lightmap, which is only re-rendered when a static light changes,
+// dynamic lights are drawn straight to the target, all of them with a single vertex array draw. A flash is a dynamic
+// light that fades out and removes itself. The (target-sized) lightmap is only created once there is a static light.
+class LightSystem : public sf::Drawable {
+
+    public:
+    struct Light {
+        sf::Vector2f position;
+        sf::Color colour;
+        float radius;
+        float lifetime = -1.0f, duration = -1.0f; // Microseconds, a flash fades from duration to 0, negative lives forever.
+        bool is_static = false;
+    };
+
+    void create ( const sf::Vector2u & size_, const std::size_t capacity_ ) {
+        m_lights.reserve ( capacity_ );
+        m_dynamic_vertices.setPrimitiveType ( sf::Quads );
+        m_dynamic_vertices.resize ( 4u * capacity_ );
+        m_dynamic_vertices.clear ( );
+        m_static_vertices.setPrimitiveType ( sf::Quads );
+        m_lightmap_size = size_;
+        create_light_texture ( 128u );
+    }
+
+    Handle add ( const sf::Vector2f & position_, const sf::Color & colour_, const float radius_, const bool is_static_ = false ) {
+        m_is_static_dirty |= is_static_;
+        return m_lights.insert ( { position_, colour_, radius_, -1.0f, -1.0f, is_static_ } );
+    }
+
+    Handle flash ( const sf::Vector2f & position_, const sf::Color & colour_, const float radius_, const float microseconds_ ) {
+        return m_lights.insert ( { position_, colour_, radius_, microseconds_, microseconds_, false } );
+    }
+
+    void remove ( const Handle handle_ ) noexcept {
+        if ( const Light * light = m_lights.get ( handle_ ) ) {
+            m_is_static_dirty |= light->is_static;
+            m_lights.erase ( handle_ );
+        }
+    }
+
+    void setPosition ( const Handle handle_, const sf::Vector2f & position_ ) noexcept {
+        if ( Light * light = m_lights.get ( handle_ ) ) {
+            light->position = position_;
+            m_is_static_dirty |= light->is_static;
+        }
+    }
+
+    void setColour ( const Handle handle_, const sf::Color & colour_ ) noexcept {
+        if ( Light * light = m_lights.get ( handle_ ) ) {
+            light->colour = colour_;
+            m_is_static_dirty |= light->is_static;
+        }
+    }
+
+    void setRadius ( const Handle handle_, const float radius_ ) noexcept {
+        if ( Light * light = m_lights.get ( handle_ ) ) {
+            light->radius = radius_;
+            m_is_static_dirty |= light->is_static;
+        }
+    }
+
+    // True iff a flash is fading (the picture changes without anything moving).
+    bool is_animating ( ) const noexcept { return m_flashes; }
+
+    // Ages the flashes by microseconds_ and rebuilds what's to be drawn.
+    void update ( const float microseconds_ ) noexcept {
+        m_flashes = 0u;
+        for ( std::size_t i = 0; i < m_lights.size ( ); ) {
+            Light & light = m_lights[ i ];
+            if ( 0.0f < light.duration ) {
+                if ( ( light.lifetime -= microseconds_ ) <= 0.0f ) {
+                    m_lights.erase ( m_lights.handle ( i ) ); // Moves the last light to i.
+                    continue;
+                }
+                ++m_flashes;
+            }
+            ++i;
+        }
+        m_dynamic_vertices.clear ( );
+        for ( const Light & light : m_lights ) {
+            if ( not light.is_static ) {
+                append ( m_dynamic_vertices, light );
+            }
+        }
+        if ( m_is_static_dirty ) {
+            render_lightmap ( );
+        }
+    }
+
+    private:
+    void draw ( sf::RenderTarget & target_, sf::RenderStates states_ ) const override {
+        states_.blendMode = sf::BlendAdd;
+        if ( m_static_vertices.getVertexCount ( ) ) {
+            target_.draw ( m_lightmap_sprite, states_ );
+        }
+        states_.texture = &m_light_texture;
+        target_.draw ( m_dynamic_vertices, states_ );
+    }
+
+    void render_lightmap ( ) {
+        m_static_vertices.clear ( );
+        for ( const Light & light : m_lights ) {
+            if ( light.is_static ) {
+                append ( m_static_vertices, light );
+            }
+        }
+        m_is_static_dirty = false;
+        if ( not m_static_vertices.getVertexCount ( ) ) {
+            return; // Not drawn.
+        }
+        if ( not m_has_lightmap ) {
+            if ( not ( m_has_lightmap = m_lightmap_texture.create ( m_lightmap_size.x, m_lightmap_size.y ) ) ) {
+                return; // The sprite has no texture, draws nothing.
+            }
+            m_lightmap_sprite.setTexture ( m_lightmap_texture.getTexture ( ), true );
+        }
+        m_lightmap_texture.clear ( sf::Color::Transparent );
+        sf::RenderStates states ( sf::BlendAdd );
+        states.texture = &m_light_texture;
+        m_lightmap_texture.draw ( m_static_vertices, states );
+        m_lightmap_texture.display ( );
+    }
+
+    void append ( sf::VertexArray & vertices_, const Light & light_ ) const noexcept {
+        sf::Color colour = light_.colour;
+        if ( 0.0f < light_.duration ) {
+            colour.a = ( sf::Uint8 ) ( colour.a * light_.lifetime / light_.duration );
+        }
+        const float size     = ( float ) m_light_texture.getSize ( ).x;
+        const sf::Vector2f p = light_.position;
+        const float r        = light_.radius;
+        vertices_.append ( sf::Vertex ( { p.x - r, p.y - r }, colour, { 0.0f, 0.0f } ) );
+        vertices_.append ( sf::Vertex ( { p.x + r, p.y - r }, colour, { size, 0.0f } ) );
+        vertices_.append ( sf::Vertex ( { p.x + r, p.y + r }, colour, { size, size } ) );
+        vertices_.append ( sf::Vertex ( { p.x - r, p.y + r }, colour, { 0.0f, size } ) );
+    }
+
+    // White, with a quadratic fall-off of the alpha, from 1 in the centre to 0 at the rim.
+    void create_light_texture ( const unsigned size_ ) {
+        sf::Image image;
+        image.create ( size_, size_, sf::Color::Transparent );
+        const float half = 0.5f * size_;
+        for ( unsigned y = 0; y < size_; ++y ) {
+            for ( unsigned x = 0; x < size_; ++x ) {
+                const float dx = ( x + 0.5f - half ) / half, dy = ( y + 0.5f - half ) / half;
+                const float f  = std::max ( 0.0f, 1.0f - std::sqrt ( dx * dx + dy * dy ) );
+                image.setPixel ( x, y, sf::Color ( 0xFF, 0xFF, 0xFF, ( sf::Uint8 ) ( 255.0f * f * f ) ) );
+            }
+        }
+        m_light_texture.loadFromImage ( image );
+        m_light_texture.setSmooth ( true );
+    }
+
+    SlotMap<Light> m_lights;
+    std::size_t m_flashes = 0u;
+    bool m_is_static_dirty = false, m_has_lightmap = false;
+
+    sf::Texture m_light_texture;
+    sf::VertexArray m_dynamic_vertices, m_static_vertices;
+    sf::Vector2u m_lightmap_size;
+    sf::RenderTexture m_lightmap_texture;
+    sf::Sprite m_lightmap_sprite;
+};
+} // namespace pong
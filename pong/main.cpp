@@ -23,9 +23,12 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstring>
 
 #include <algorithm>
 #include <array>
+#include <charconv>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <functional>
@@ -33,10 +36,12 @@
 #include <limits>
 #include <list>
 #include <map>
+#include <memory>
 #include <optional>
 #include <random>
 #include <sax/iostream.hpp> // <iostream> + nl, sp etc. defined...
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -49,49 +54,19 @@
 
 #include <sax/autotimer.hpp>
 #include <sax/prng.hpp>
-#include <sax/uniform_int_distribution.hpp>
 
+#include "allocation.hpp"
+#include "assets.hpp"
+#include "broadcast.hpp"
+#include "environment.hpp"
+#include "game.hpp"
+#include "idle.hpp"
+#include "latency.hpp"
+#include "lights.hpp"
+#include "random.hpp"
 #include "resource.h"
 #include "type_traits.hpp"
-
-/*
-                        C3-----------------------------------N-----------------------------------C0
-                        |                                                                         |
-                        |                                                                         |
-                        |                                                                         |
-                        |                                                                         |
-                        |                                                                         |
-                        |                                                                         |
-                        |                                                                         |
-                        |                                                                         |
-                        |           0.0 pi / 2.0 pi                                               |
-                        W                  |                                                      E
-                        |          Q3      |      Q0                                              |
-                        |                  |                                                      |
-                        |   1.5 pi -------Pos------- 0.5 pi                                       |
-                        |                  |                                                      |
-                        |          Q2      |      Q1                                              |
-                        |                  |                                                      |
-                        |                1.0 pi                                                   |
-                        |                                                                         |
-                        |                                                                         |
-                        |                                                                         |
-                        C2-----------------------------------S-----------------------------------C1
-*/
-
-// Random stuff...
-
-using Rng     = sax::Rng;
-using UniDisi = sax::uniform_int_distribution<sf::Int32>;
-using UniDisf = std::uniform_real_distribution<float>;
-using NorDisf = std::normal_distribution<float>;
-using BerDisf = std::bernoulli_distribution;
-
-namespace pong {
-
-bool equal ( const float a_, const float b_ ) noexcept { return std::abs ( b_ - a_ ) < 4.0f * FLT_EPSILON; }
-bool not_equal ( const float a_, const float b_ ) noexcept { return std::abs ( b_ - a_ ) >= 4.0f * FLT_EPSILON; }
-} // namespace pong
+#include "video.hpp"
 
 struct Sizes {
 
@@ -104,346 +79,120 @@ struct Sizes {
 
 struct Numbers {
 
-    sf::Texture m_numbers_texture;
-    sf::Sprite m_numbers_sprite;
+    pong::Asset<sf::Texture> m_numbers_texture;
 
     Sizes m_sizes;
 
-    Numbers ( ) {
-        sf::loadFromResource ( m_numbers_texture, __NUMBERS_TEXTURE__ );
-        m_numbers_sprite.setTexture ( m_numbers_texture );
-        m_sizes = m_numbers_texture.getSize ( );
+    void create ( pong::AssetCache & assets_ ) {
+        m_numbers_texture = assets_.acquire<sf::Texture> ( __NUMBERS_TEXTURE__ );
+        m_sizes = m_numbers_texture->getSize ( );
         m_sizes.width /= 10;
     }
-
-    sf::IntRect getRect ( const sf::Int32 number_ ) const noexcept {
-        return { number_ * m_sizes.width, 0, m_sizes.width, m_sizes.height };
-    }
 };
 
-struct Score {
-
-    Numbers m_numbers;
+// The score as textured quads into the numbers-atlas, both scores are drawn in one go. The quads are only rebuilt
+// when the score changes.
+struct ScoreBoard {
 
-    sf::Int32 m_left, m_right;
-    sf::Text m_left_text, m_right_text;
     sf::Point m_left_pos, m_right_pos;
-    sf::RenderWindowPtr m_render_window_ptr;
-    sf::Font m_numbers_font;
-
-    Score ( ) : m_left ( 0 ), m_right ( 0 ) {}
-
-    void create ( sf::RenderWindowRef rwr_, const sf::FloatBox & m_table_box_ ) noexcept {
-        m_render_window_ptr = &rwr_;
-        sf::loadFromResource ( m_numbers_font, __NUMBERS_FONT__ );
-        const sf::Vector2f p = m_table_box_.getSize ( );
-        constexpr float shadow_offset = -5.0f;
-        m_left_pos.x = std::round ( m_table_box_.left + 0.4f * p.x + shadow_offset );
-        m_left_pos.y = std::round ( m_table_box_.top + 0.05f * p.y );
-        create_text ( m_left_text, 0.15f * p.y, m_left_pos );
-        update_text ( m_left_text, m_left + shadow_offset );
-        m_right_pos.x = std::round ( m_table_box_.left + 0.6f * p.x + shadow_offset );
-        m_right_pos.y = m_left_pos.y;
-        create_text ( m_right_text, 0.15f * p.y, m_right_pos );
-        update_text ( m_right_text, m_right );
-    }
+    sf::Vector2f m_digit_size;
+    sf::VertexArray m_vertices;
 
-    void update ( ) noexcept {
-        update_text ( m_left_text, m_left );
-        update_text ( m_right_text, m_right );
+    ScoreBoard ( ) : m_vertices ( sf::Quads ) {
+        // Room for the longest scores, so the quads never reallocate in the frame loop.
+        m_vertices.resize ( 2u * 4u * ( std::numeric_limits<sf::Int32>::digits10 + 1u ) );
+        m_vertices.clear ( );
     }
 
-    void reset ( ) noexcept {
-        m_left = 0, m_right = 0;
-        update ( );
+    // atlas_ are the sizes of a single digit in the atlas.
+    void create ( const sf::FloatBox & m_table_box_, const Sizes & atlas_ ) noexcept {
+        m_atlas                       = atlas_;
+        const sf::Vector2f p          = m_table_box_.getSize ( );
+        constexpr float shadow_offset = -5.0f;
+        m_left_pos.x                  = std::round ( m_table_box_.left + 0.4f * p.x + shadow_offset );
+        m_left_pos.y                  = std::round ( m_table_box_.top + 0.05f * p.y );
+        m_right_pos.x                 = std::round ( m_table_box_.left + 0.6f * p.x + shadow_offset );
+        m_right_pos.y                 = m_left_pos.y;
+        m_digit_size.y                = std::round ( 0.15f * p.y );
+        m_digit_size.x                = std::round ( m_digit_size.y * m_atlas.width / ( float ) m_atlas.height );
+        m_displayed_left              = -1; // Forces a rebuild.
+        update ( Score ( ) );
+    }
+
+    void update ( const Score & score_ ) noexcept {
+        if ( score_.m_left == m_displayed_left and score_.m_right == m_displayed_right ) {
+            return;
+        }
+        m_displayed_left = score_.m_left, m_displayed_right = score_.m_right;
+        m_vertices.clear ( );
+        append_number ( score_.m_left, m_left_pos );
+        append_number ( score_.m_right, m_right_pos );
     }
 
-    bool has_won ( ) const noexcept { return m_left > 10 or m_right > 10; }
-
     private:
-    void create_text ( sf::Text & text_, const float size_, const sf::Point & position_ ) const noexcept {
-        text_.setString ( ( char ) ( 0 + 48 ) );
-        text_.setCharacterSize ( size_ );
-        text_.setFont ( m_numbers_font );
-        text_.setStyle ( sf::Text::Regular );
-        text_.setFillColor ( sf::Color ( 0xCB, 0xCB, 0xCB ) );
-        sf::centreOrigin ( text_ );
-        text_.setPosition ( position_ );
+    Sizes m_atlas;
+    sf::Int32 m_displayed_left = -1, m_displayed_right = -1;
+
+    // Appends the digits of number_, centred on position_.
+    void append_number ( sf::Int32 number_, const sf::Point & position_ ) noexcept {
+        std::array<sf::Int32, std::numeric_limits<sf::Int32>::digits10 + 1> digits;
+        sf::Int32 n = 0;
+        do {
+            digits[ n++ ] = number_ % 10;
+            number_ /= 10;
+        } while ( number_ );
+        const sf::Color colour ( 0xCB, 0xCB, 0xCB );
+        sf::Point top_left ( position_.x - 0.5f * n * m_digit_size.x, position_.y - 0.5f * m_digit_size.y );
+        const float w = ( float ) m_atlas.width, h = ( float ) m_atlas.height;
+        while ( n-- ) {
+            const float l = digits[ n ] * w;
+            m_vertices.append ( sf::Vertex ( top_left, colour, { l, 0.0f } ) );
+            m_vertices.append ( sf::Vertex ( { top_left.x + m_digit_size.x, top_left.y }, colour, { l + w, 0.0f } ) );
+            m_vertices.append ( sf::Vertex ( top_left + m_digit_size, colour, { l + w, h } ) );
+            m_vertices.append ( sf::Vertex ( { top_left.x, top_left.y + m_digit_size.y }, colour, { l, h } ) );
+            top_left.x += m_digit_size.x;
+        }
     }
-
-    void update_text ( sf::Text & text_, const sf::Int32 score_ ) const noexcept { text_.setString ( ( char ) ( score_ + 48 ) ); }
 };
 
-struct Ball {
+// The player's paddle controller, the paddle follows the mouse (vertically).
+struct PlayerController {
 
-    enum class Direction : sf::Int32 { MovesToRight = 0, MovesToLeft = 1 };
-    enum class Event : sf::Int32 { None = 0, HitWall = 1, Missed = 2 };
-
-    mutable Rng m_rng;
-    sf::SquareShape m_shape;
-    float m_angle, m_speed_increment, m_speed;
-    sf::Point m_min, m_max;
-    Direction m_direction;
-    sf::Point m_previous_position;
     sf::RenderWindowPtr m_render_window_ptr;
+    float m_mouse_min, m_mouse_max, m_ratio_y;
 
-    float m_pause;
-
-    Ball ( const float size_ ) :
-        m_rng ( sax::os_seed ( ) ),
-        m_shape ( sf::makeOdd ( size_ ) ), m_angle ( UniDisf ( 0.333f * sf::pi, 0.666f * sf::pi ) ( m_rng ) ),
-        m_speed_increment ( 60.0f / ( float ) sf::getScreenRefreshRate ( ) ), m_speed ( 10.0f * m_speed_increment ),
-        m_direction ( ( Direction ) ( m_angle / sf::pi ) ), m_pause ( 0.0f ) {}
-
-    void create ( sf::RenderWindowRef rwr_, const sf::FloatBox & m_table_box_ ) noexcept {
-        m_render_window_ptr = &rwr_;
-        const float half_ball_size = 0.5 * m_shape.getSize ( ).x;
-        m_min = { m_table_box_.left + half_ball_size, m_table_box_.top + half_ball_size },
-        m_max = { m_table_box_.right - half_ball_size, m_table_box_.bottom - half_ball_size };
-        m_shape.setFillColor ( sf::Color ( 0xE1, 0xE1, 0xE1 ) );
-        sf::centreOrigin ( m_shape );
-        m_shape.setPosition ( UniDisf ( m_min.x, m_max.x ) ( m_rng ), UniDisf ( m_min.y, m_max.y ) ( m_rng ) );
-    }
-
-    void new_ball ( sf::Point & position_ ) noexcept {
-        const bool coin_toss = BerDisf ( ) ( m_rng );
-        if ( m_direction == Direction::MovesToLeft ) {
-            m_angle = coin_toss ? UniDisf ( 1.22f * sf::pi, 1.33f * sf::pi ) ( m_rng )
-                                : UniDisf ( 1.66f * sf::pi, 1.78f * sf::pi ) ( m_rng );
-        }
-        else {
-            m_angle = coin_toss ? UniDisf ( 0.66f * sf::pi, 0.78f * sf::pi ) ( m_rng )
-                                : UniDisf ( 0.22f * sf::pi, 0.33f * sf::pi ) ( m_rng );
-        }
-        position_ = { ( m_max.x - m_min.x ) * 0.5f + m_min.x,
-                      ( m_max.y - m_min.y ) * ( 0.1f + ( float ) coin_toss * 0.8f ) + m_min.y };
-        m_speed = 10.0f;
-    }
-
-    void pause ( const float microseconds_ ) noexcept { m_pause = microseconds_; }
+    // The last mouse sample, for latency measurements.
+    pong::LatencyRecorder::Clock::time_point m_sample_time;
+    float m_sample_y    = 0.0f;
+    bool m_has_sample   = false; // Sampled since the last take_sample ( ).
+    bool m_sample_moved = false; // Differs from the previous sample.
 
-    Event update ( Score & score_ ) noexcept {
-        static const float inc = 1'000'000.0f / sf::getScreenRefreshRate ( );
-        if ( 0.0f < m_pause ) {
-            m_pause -= inc;
-            return Event::None;
-        }
-        else {
-            m_pause = 0.0f;
-        }
-        Event event = Event::None;
-        m_previous_position    = m_shape.getPosition ( );
-        sf::Point new_position = m_previous_position + m_speed * sf::Force ( std::sin ( m_angle ), std::cos ( m_angle ) );
-        if ( new_position.x < m_min.x or new_position.x > m_max.x ) {
-            score_.m_right += new_position.x < m_min.x;
-            score_.m_left += new_position.x > m_max.x;
-            event = Event::Missed;
-            new_ball ( new_position );
-        }
-        if ( new_position.y < m_min.y or new_position.y > m_max.y ) {
-            m_angle        = sf::clampRadians ( sf::pi - m_angle + NorDisf ( 0.0f, 0.0125f ) ( m_rng ) );
-            m_direction    = ( Direction ) ( m_angle / sf::pi );
-            new_position.y = new_position.y < m_min.y ? m_min.y : m_max.y;
-            event          = Event::HitWall;
-        }
-        m_shape.setPosition ( new_position );
-        return event;
+    void create ( sf::RenderWindowPtr rwp_, const sf::Int32 desktop_height_, const pong::RandomStream & ) noexcept {
+        m_render_window_ptr = rwp_;
+        m_mouse_min         = pong::geometry::paddle_mouse_ratio * desktop_height_;
+        m_mouse_max         = ( 1.0f - pong::geometry::paddle_mouse_ratio ) * desktop_height_;
+        m_ratio_y           = ( pong::geometry::paddle_max_y - pong::geometry::paddle_min_y ) / ( m_mouse_max - m_mouse_min );
     }
-};
 
-
-#define PADDLE_MOUSE_RATIO 0.4125f
-#define PADDLE_MOUSE_MIN_HEIGHT ( ( PADDLE_MOUSE_RATIO ) *sf::VideoMode::getDesktopMode ( ).height )
-#define PADDLE_MOUSE_MAX_HEIGHT ( ( 1.0f - ( PADDLE_MOUSE_RATIO ) ) * sf::VideoMode::getDesktopMode ( ).height )
-
-
-struct Paddle {
-    enum class Side : sf::Int32 { Left = 0, Right = 1 };
-    mutable Rng m_rng;
-    const float m_mouse_min, m_mouse_max, m_paddle_length;
-    float m_paddle_detector_length;
-    sf::Vector2f m_paddle_detector_offset;
-    const sf::Int32 m_paddle_sectors;
-    sf::RectangleShape m_shape;
-    sf::RenderWindowPtr m_render_window_ptr;
-    float m_min_y, m_max_y, m_ratio_y;
-    Side m_side = Side::Left;
-    float m_pause;
-
-    Paddle ( const float ball_size_, const float paddle_size_ ) :
-        m_rng ( sax::os_seed ( ) ),
-        m_mouse_min ( PADDLE_MOUSE_MIN_HEIGHT ), m_mouse_max ( PADDLE_MOUSE_MAX_HEIGHT ),
-        m_paddle_length ( sf::makeOdd ( 6.0f * sf::makeOdd ( paddle_size_ ) ) ),
-        m_paddle_detector_length ( m_paddle_length + ball_size_ ),
-        m_paddle_detector_offset ( 0.5f * ( ball_size_ + paddle_size_ ), -0.5f * ( m_paddle_length + ball_size_ ) ),
-        m_paddle_sectors ( 15 ), // Has to be odd.
-        m_shape ( sf::Vector2f{ sf::makeOdd ( paddle_size_ ), m_paddle_length } ),
-        m_pause ( 0.0f ) {
-        assert ( m_paddle_sectors & 1 );
-    }
-
-    void create ( sf::RenderWindowRef rwr_, const sf::FloatBox & m_table_box_, const Side side_ ) noexcept {
-        if ( Side::Right == side_ ) {
-            m_paddle_detector_offset.x *= -1.0f;
-        }
-        m_render_window_ptr = &rwr_;
-        m_shape.setFillColor ( sf::Color ( 0xCB, 0xCB, 0xCB ) );
-        sf::centreOrigin ( m_shape );
-        constexpr float rim_offset = 61.0f;
-        m_shape.setPosition ( Side::Right == side_ ? sf::makeOdd ( m_table_box_.right - rim_offset, true )
-                                                   : sf::makeOdd ( m_table_box_.left + rim_offset, false ),
-                              rwr_.getSize ( ).y / 2.0f );
-        m_min_y = m_table_box_.top + 0.075f * ( m_table_box_.bottom - m_table_box_.top );
-        m_max_y = m_table_box_.bottom - 0.075f * ( m_table_box_.bottom - m_table_box_.top );
-        m_ratio_y = ( 0.85f * ( m_table_box_.bottom - m_table_box_.top ) ) / ( m_mouse_max - m_mouse_min );
-        m_side = side_;
-    }
-
-    bool update_player ( Ball & ball_ ) noexcept {
-        static const float inc = 1'000'000.0f / sf::getScreenRefreshRate ( );
-        if ( 0.0f < m_pause ) {
-            m_pause -= inc;
-            return false;
-        }
-        else {
-            m_pause = 0.0f;
-        }
+    template<pong::Side S>
+    float next_y ( const sf::Point &, const Ball & ) noexcept {
         const float mouse_y =
             ( float ) ( sf::Mouse::getPosition ( *m_render_window_ptr ).y + sf::getWindowTop ( *m_render_window_ptr ) );
-        sf::Point ball_position ( ball_.m_shape.getPosition ( ) );
-        sf::Point paddle_position ( m_shape.getPosition ( ).x,
-                                    m_min_y + m_ratio_y * ( std::clamp ( mouse_y, m_mouse_min, m_mouse_max ) - m_mouse_min ) );
-        return update ( ball_, ball_position, paddle_position );
-    }
-
-    bool is_y_in_paddle ( const float paddle_centre_y_, const float y_ ) const noexcept {
-        // Does the value of y fall into the range of the paddle?
-        return y_ > ( paddle_centre_y_ - 0.4f * m_paddle_length ) and y_ < ( paddle_centre_y_ + 0.4f * m_paddle_length );
-    }
-
-    bool update_computer ( Ball & ball_ ) noexcept {
-        static const float inc = 1'000'000.0f / sf::getScreenRefreshRate ( );
-        if ( 0.0f < m_pause ) {
-            m_pause -= inc;
-            return false;
-        }
-        else {
-            m_pause = 0.0f;
-        }
-        sf::Point ball_position (
-            ball_.m_shape.getPosition ( ) ); // +UniDisf ( 0.5f * -7.0f / 15.0f, 0.5f * 7.0f / 15.0f ) ( m_rng ) * m_paddle_length;
-        sf::Point paddle_position ( m_shape.getPosition ( ) );
-        if ( not( is_y_in_paddle ( paddle_position.y, ball_position.y ) ) ) {
-            if ( ( ( Side::Left == m_side ? Ball::Direction::MovesToLeft == ball_.m_direction
-                                          : Ball::Direction::MovesToRight == ball_.m_direction )
-                       ? ball_position.y
-                       : ( m_min_y + m_max_y ) / 2.0f ) < paddle_position.y ) {
-                const float new_paddle_position_y =
-                    sf::makeOdd ( paddle_position.y - 9.0f + 9.0f * UniDisf ( -7.0f / 15.0f, 7.0f / 15.0f ) ( m_rng ), false );
-                if ( new_paddle_position_y > m_min_y ) {
-                    if ( ball_position.y < new_paddle_position_y ) {
-                        paddle_position.y = new_paddle_position_y;
-                    }
-                }
-            }
-            else {
-                const float new_paddle_position_y =
-                    sf::makeOdd ( paddle_position.y + 9.0f + 9.0f * UniDisf ( -7.0f / 15.0f, 7.0f / 15.0f ) ( m_rng ), true );
-                if ( new_paddle_position_y < m_max_y ) {
-                    if ( ball_position.y > new_paddle_position_y ) {
-                        paddle_position.y = new_paddle_position_y;
-                    }
-                }
-            }
-        }
-        return update ( ball_, ball_position, paddle_position );
-    }
-
-    void pause ( const float microseconds_ ) noexcept { m_pause = microseconds_; }
-
-    private:
-    bool update ( Ball & ball_, sf::Point & ball_position_, sf::Point & paddle_position_ ) noexcept {
-        m_shape.setPosition ( paddle_position_ );
-        paddle_position_ += m_paddle_detector_offset;
-
-        // Update and return true iff paddle hits the ball.
-
-        // const sf::Point ball_current_position = ball_.m_shape.getPosition ( ); // Before potentially being returned, i.e. could
-        // be behind the paddle....
-
-        // Weed out all the positions that are guaranteed to hit the paddle.
-
-        if ( Side::Left == m_side ) {
-            if ( Ball::Direction::MovesToRight == ball_.m_direction or
-                 ( ball_position_.x > paddle_position_.x or ball_.m_previous_position.x < paddle_position_.x ) ) {
-                return false;
-            }
-        }
-        else {
-            if ( Ball::Direction::MovesToLeft == ball_.m_direction or
-                 ( ball_position_.x < paddle_position_.x or ball_.m_previous_position.x > paddle_position_.x ) ) {
-                return false;
-            }
-        }
-
-        // Could have intersect...
-
-        sf::Point intersection = ball_position_ - ball_.m_previous_position;
-
-        if ( pong::not_equal ( 0.0f, intersection.x ) ) { // Not vertical (slope (s) is inf).
-            const float s = intersection.y / intersection.x;
-            // y = s * x + b
-            intersection.y = s * ( paddle_position_.x - ball_position_.x ) + ball_position_.y;
-            if ( intersection.y >= paddle_position_.y and intersection.y <= ( paddle_position_.y + m_paddle_detector_length ) ) {
-                intersection.x = paddle_position_.x;
-                return_ball ( ball_, intersection,
-                              ( ball_position_.x - ball_.m_previous_position.x ) /
-                                  ( ball_position_.x - ball_.m_previous_position.x ) );
-                return true;
-            }
-            return false;
-        }
-
-        else { // Vertical: detector and ball trajectory are colinear with overlap.
-            intersection = paddle_position_; // Select top of detector (assume ball comes from top).
-            if ( ball_.m_previous_position.y > paddle_position_.y ) {
-                // If the ball comes from below, switch to the bottom of the detector.
-                intersection.y += m_paddle_detector_length;
-            }
-            return_ball ( ball_, intersection,
-                          1.0f - ( intersection.x - ball_.m_previous_position.x ) /
-                                     ( ball_position_.x - ball_.m_previous_position.x ) );
-            return true;
-        }
-    }
-
-    void return_ball ( Ball & ball_, const sf::Point & intersection_, const float ratio_ ) const noexcept {
-        constexpr float epsilon = 0.01f * sf::pi;
-        const float zero_pi_or_one_pi = ( float ) ( Ball::Direction::MovesToRight == ball_.m_direction ) * sf::pi;
-        float angle                   = sf::half_pi + zero_pi_or_one_pi;
-        angle += 0.075f * ( Side::Right == m_side ? sector_hit ( ball_ ) : -sector_hit ( ball_ ) );
-        angle += NorDisf ( 0.0f, 0.025f ) ( ball_.m_rng );
-        ball_.m_angle     = std::clamp ( angle, zero_pi_or_one_pi + epsilon, sf::pi + zero_pi_or_one_pi - epsilon );
-        ball_.m_direction = ( Ball::Direction ) ( ball_.m_angle / sf::pi );
-        // Set x-value of the ball so that it won't surpass the paddle on the wrong side.
-        ball_.m_speed += ball_.m_speed_increment;
-        ball_.m_shape.setPosition ( intersection_ +
-                                    ball_.m_speed * ratio_ * sf::Force ( std::sin ( ball_.m_angle ), std::cos ( ball_.m_angle ) ) );
-    }
-
-    float sector_hit ( Ball & ball_ ) const noexcept {
-        return ( float ) ( std::clamp ( ( ball_.m_shape.getPosition ( ).y - m_shape.getGlobalBounds ( ).top ) / m_paddle_length,
-                                        0.0f, 0.999f ) *
-                               m_paddle_sectors -
-                           m_paddle_sectors / 2u );
+        m_sample_time  = pong::LatencyRecorder::Clock::now ( );
+        m_sample_moved = pong::not_equal ( m_sample_y, mouse_y );
+        m_sample_y     = mouse_y;
+        m_has_sample   = true;
+        return pong::geometry::paddle_min_y + m_ratio_y * ( std::clamp ( mouse_y, m_mouse_min, m_mouse_max ) - m_mouse_min );
     }
 };
 
+using PlayerPaddle = Paddle<pong::Side::Right, PlayerController>;
+
 struct App {
 
-    // Generator.
+    // Generators, all randomness of a match derives from the master seed.
 
-    mutable Rng m_rng;
+    pong::RandomStreams m_random_streams;
 
     // Draw stuff.
 
@@ -459,14 +208,16 @@ struct App {
 
     // Resources.
 
-    sf::SoundBuffer m_hit_wall_soundbuffer, m_hit_paddle_soundbuffer, m_miss_ball_soundbuffer;
-    sf::Sound m_hit_wall_sound, m_hit_paddle_sound, m_miss_ball_sound;
+    pong::AssetCache m_assets;
 
-    sf::Font m_regular_font, m_bold_font, m_mono_font, m_numbers_font;
+    pong::Asset<sf::SoundBuffer> m_hit_wall_soundbuffer, m_hit_paddle_soundbuffer, m_miss_ball_soundbuffer;
+    sf::Sound m_hit_wall_sound, m_hit_paddle_sound, m_miss_ball_sound;
 
-    sf::Texture m_rim_texture;
+    pong::Asset<sf::Texture> m_rim_texture;
     sf::Sprite m_rim_sprite;
 
+    Numbers m_numbers;
+
     // Drag related.
 
     sf::Int32 m_desktop_height;
@@ -474,23 +225,44 @@ struct App {
     sf::Vector2i m_grabbed_offset;
     bool m_is_window_grabbed;
 
+    // Power.
+
+    pong::IdleScheduler m_idle_scheduler;
+    bool m_has_focus = true;
+
     // The objects on the table.
 
-    Ball m_ball;
-    Paddle m_player_paddle;
-    Paddle m_computer_paddle;
-    Score m_score;
+    Match<ComputerPaddle, PlayerPaddle> m_match;
+    ScoreBoard m_score_board;
+
+    // Glow, the ball glows and things flash when hit.
+
+    pong::LightSystem m_lights;
+    pong::Handle m_ball_light;
+
+    // Latency measurement.
+
+    std::unique_ptr<pong::LatencyRecorder> m_latency_recorder;
+    sf::RectangleShape m_latency_marker;
+    bool m_show_latency_marker = false;
+
+    // Spectators.
+
+    std::unique_ptr<pong::broadcast::Server> m_broadcast_server;
+    std::uint32_t m_tick = 0u;
 
     sf::Event m_event;
 
-    App ( ) :
+    App ( const std::uint64_t master_seed_ = sax::os_seed ( ) ) :
 
-        m_rng ( sax::os_seed ( ) ), m_is_window_grabbed ( false ), m_ball ( 15.0f ), m_player_paddle ( 15.0f, 11.0f ),
-        m_computer_paddle ( 15.0f, 11.0f ) {
+        m_random_streams ( master_seed_ ), m_frame_rate ( display_rate ( ) ),
+        m_frame_duration_as_microseconds ( 1'000'000.0f / m_frame_rate ), m_is_window_grabbed ( false ),
+        m_match ( m_random_streams, m_frame_rate ) {
 
         m_context_settings.antialiasingLevel = 8u;
 
-        m_render_window.create ( sf::VideoMode ( 1200u, 900u ), L"", sf::Style::None, m_context_settings );
+        m_render_window.create ( sf::VideoMode ( pong::geometry::window_width, pong::geometry::window_height ), L"",
+                                 sf::Style::None, m_context_settings );
         m_render_window.setVerticalSyncEnabled ( true );
         m_render_window.requestFocus ( );
         m_render_window.setMouseCursorGrabbed ( true );
@@ -499,48 +271,35 @@ struct App {
 
         m_render_window_bounds = sf::FloatRect ( 0.0f, 0.0f, m_render_window.getSize ( ).x, m_render_window.getSize ( ).y );
 
-        constexpr float rim_size = 100.0f, shadow_offset = -5.0f;
+        m_table_box = pong::geometry::table_box ( );
 
-        m_table_box = sf::FloatBox ( rim_size + shadow_offset, rim_size + shadow_offset,
-                                     ( float ) ( m_render_window.getSize ( ).x - rim_size ) + shadow_offset,
-                                     ( float ) ( m_render_window.getSize ( ).y - rim_size ) + shadow_offset );
+        m_desktop_height = sf::VideoMode::getDesktopMode ( ).height;
 
-        m_ball.create ( m_render_window, m_table_box );
-        m_player_paddle.create ( m_render_window, m_table_box, Paddle::Side::Right );
-        m_computer_paddle.create ( m_render_window, m_table_box, Paddle::Side::Left );
-        m_score.create ( m_render_window, m_table_box );
+        m_numbers.create ( m_assets );
 
-        // Frames.
+        m_match.create ( &m_render_window, m_desktop_height, m_random_streams );
+        m_score_board.create ( m_table_box, m_numbers.m_sizes );
 
-        m_frame_rate                     = sf::getScreenRefreshRate ( );
-        m_frame_duration_as_microseconds = 1'000'000.0f / m_frame_rate;
+        m_lights.create ( m_render_window.getSize ( ), 16u );
+        m_ball_light = m_lights.add ( m_match.m_ball.m_shape.getPosition ( ), sf::Color ( 0xE1, 0xE1, 0xE1, 0x30 ), 45.0f );
 
         // Set icon.
 
         // set_icon ( );
 
-        // Load sound-buffers.
-
-        sf::loadFromResource ( m_hit_wall_soundbuffer, __HIT_WALL_SOUND__ );
-        sf::loadFromResource ( m_hit_paddle_soundbuffer, __HIT_PADDLE_SOUND__ );
-        sf::loadFromResource ( m_miss_ball_soundbuffer, __MISS_BALL_SOUND__ );
-
-        // Set sounds.
-
-        m_hit_wall_sound.setBuffer ( m_hit_wall_soundbuffer );
-        m_hit_paddle_sound.setBuffer ( m_hit_paddle_soundbuffer );
-        m_miss_ball_sound.setBuffer ( m_miss_ball_soundbuffer );
-
-        // Load font.
+        // Sound-buffers, decoded here (some 43KB of pcm) and not on the first hit, in the frame loop.
 
-        sf::loadFromResource ( m_numbers_font, __NUMBERS_FONT__ );
+        m_hit_wall_soundbuffer   = m_assets.acquire<sf::SoundBuffer> ( __HIT_WALL_SOUND__ );
+        m_hit_paddle_soundbuffer = m_assets.acquire<sf::SoundBuffer> ( __HIT_PADDLE_SOUND__ );
+        m_miss_ball_soundbuffer  = m_assets.acquire<sf::SoundBuffer> ( __MISS_BALL_SOUND__ );
+        m_hit_wall_sound.setBuffer ( *m_hit_wall_soundbuffer );
+        m_hit_paddle_sound.setBuffer ( *m_hit_paddle_soundbuffer );
+        m_miss_ball_sound.setBuffer ( *m_miss_ball_soundbuffer );
 
         // Load textures and set sprites.
 
-        sf::loadFromResource ( m_rim_texture, __PONG_RIM__ );
-        m_rim_sprite.setTexture ( m_rim_texture );
-
-        m_desktop_height = sf::VideoMode::getDesktopMode ( ).height;
+        m_rim_texture = m_assets.acquire<sf::Texture> ( __PONG_RIM__ );
+        m_rim_sprite.setTexture ( *m_rim_texture );
 
         m_render_window.clear ( sf::Color::Transparent );
         m_render_window.draw ( m_rim_sprite );
@@ -551,12 +310,65 @@ struct App {
 
     bool is_active ( ) const noexcept { return m_render_window.isOpen ( ); }
 
+    // The game steps once per (vsync'ed) frame, at the fixed tick rate if the display doesn't tell its rate.
+    static sf::Int32 display_rate ( ) noexcept {
+        const sf::Int32 rate = sf::getScreenRefreshRate ( );
+        return 0 < rate ? rate : pong::geometry::tick_rate;
+    }
+
+    // Measures the latency of the mouse samples of the player paddle from now on, the marker (top left corner of the rim)
+    // lights up in frames in which the sample differs from the previous one, for calibration with a camera.
+    void measure_latency ( const bool show_marker_ ) {
+        m_latency_recorder    = std::make_unique<pong::LatencyRecorder> ( );
+        m_show_latency_marker = show_marker_;
+        m_latency_marker.setSize ( { 40.0f, 40.0f } );
+        m_latency_marker.setPosition ( 20.0f, 20.0f );
+    }
+
+    void report_latency ( std::ostream & out_ ) const {
+        if ( m_latency_recorder ) {
+            m_latency_recorder->report ( out_ );
+        }
+    }
+
+    // Publishes the state of the match to spectators (on udp port_) from now on.
+    bool broadcast ( const unsigned short port_ ) {
+        m_broadcast_server = std::make_unique<pong::broadcast::Server> ( );
+        if ( not m_broadcast_server->start ( port_ ) ) {
+            m_broadcast_server.reset ( );
+            return false;
+        }
+        return true;
+    }
+
     void run ( ) noexcept {
         poll_events ( );
+        if ( not m_has_focus ) {
+            // The match is frozen in the background, only look at the events, a few times per second (or on input).
+            m_idle_scheduler.wait ( pong::IdleScheduler::Mode::Background, std::chrono::milliseconds ( 250 ) );
+            return;
+        }
         update_state ( );
+        stamp ( pong::LatencyRecorder::Updated );
         render_objects ( );
+        const float idle_microseconds = nothing_moves_for ( );
+        record_latency ( );
+        m_idle_scheduler.tick ( );
+        // What arrived while drawing sits in sfml's queue, where it doesn't wake the wait, handle it first.
+        if ( 0.0f < idle_microseconds and not poll_events ( ) and m_has_focus ) {
+            // Nothing to draw until then, unless input arrives.
+            using Microseconds = std::chrono::duration<float, std::micro>;
+            const auto waited  = m_idle_scheduler.wait ( pong::IdleScheduler::Mode::Idle,
+                                                        std::chrono::duration_cast<pong::IdleScheduler::Clock::duration> (
+                                                            Microseconds ( idle_microseconds ) ) );
+            m_match.elapse ( Microseconds ( waited ).count ( ) );
+        }
     }
 
+    void report_power ( std::ostream & out_ ) const { m_idle_scheduler.report ( out_ ); }
+
+    void report_assets ( std::ostream & out_ ) { m_assets.report ( out_ ); }
+
     private:
     void set_icon ( ) {
         HICON hicon = LoadIcon ( GetModuleHandle ( NULL ), MAKEINTRESOURCE ( __IDI_ICON1__ ) );
@@ -568,9 +380,15 @@ struct App {
         }
     }
 
-    void poll_events ( ) noexcept {
-        if ( m_render_window.pollEvent ( m_event ) ) {
-            if ( sf::Event::MouseMoved == m_event.type ) {
+    // Handles all pending events, returns false iff there were none.
+    bool poll_events ( ) noexcept {
+        bool has_events = false;
+        while ( m_render_window.pollEvent ( m_event ) ) {
+            has_events = true;
+            if ( sf::Event::LostFocus == m_event.type or sf::Event::GainedFocus == m_event.type ) {
+                m_has_focus = sf::Event::GainedFocus == m_event.type;
+            }
+            else if ( sf::Event::MouseMoved == m_event.type ) {
                 if ( m_is_window_grabbed ) {
                     m_render_window.setPosition ( sf::Mouse::getPosition ( ) + m_grabbed_offset );
                 }
@@ -596,50 +414,467 @@ struct App {
                 }
             }
         }
+        return has_events;
     }
 
     void update_state ( ) noexcept {
-
-        const Ball::Event event = m_ball.update ( m_score );
-
-        if ( Ball::Event::HitWall == event ) {
+        const auto events = m_match.step ( );
+        const sf::Point ball_position = m_match.m_ball.m_shape.getPosition ( );
+        if ( Ball::Event::HitWall == events.ball ) {
             m_hit_wall_sound.play ( );
+            m_lights.flash ( ball_position, sf::Color ( 0xE1, 0xE1, 0xE1, 0x60 ), 60.0f, 150'000.0f );
         }
-        else if ( Ball::Event::Missed == event ) {
+        else if ( Ball::Event::Missed == events.ball ) {
             m_miss_ball_sound.play ( );
-            m_ball.pause ( 500'000.0f );
-            if ( Ball::Direction::MovesToLeft == m_ball.m_direction ) {
-                m_computer_paddle.pause ( 500'000.0f + 333'333.3f / 2.0f );
-            }
         }
-        if ( m_player_paddle.update_player ( m_ball ) ) {
+        if ( events.hit_paddle ) {
             m_hit_paddle_sound.play ( );
-            m_computer_paddle.pause ( 333'333.3f );
+            const sf::Point paddle_position = pong::Side::Left == events.paddle_side
+                                                  ? m_match.m_left_paddle.m_shape.getPosition ( )
+                                                  : m_match.m_right_paddle.m_shape.getPosition ( );
+            m_lights.flash ( paddle_position, sf::Color ( 0xFF, 0xFF, 0xFF, 0xA0 ), 120.0f, 250'000.0f );
         }
-        if ( m_computer_paddle.update_computer ( m_ball ) ) {
-            m_hit_paddle_sound.play ( );
-            m_player_paddle.pause ( 333'333.3f );
+        m_lights.setPosition ( m_ball_light, ball_position );
+        m_lights.update ( m_frame_duration_as_microseconds );
+        m_score_board.update ( m_match.m_score );
+        ++m_tick;
+        if ( m_broadcast_server ) {
+            publish ( );
         }
-        m_score.update ( );
+    }
+
+    void publish ( ) noexcept {
+        using Snapshot = pong::broadcast::Snapshot;
+        Snapshot snapshot;
+        snapshot.tick                           = m_tick;
+        snapshot.fields[ Snapshot::BallX ]      = Snapshot::quantize_position ( m_match.m_ball.m_shape.getPosition ( ).x );
+        snapshot.fields[ Snapshot::BallY ]      = Snapshot::quantize_position ( m_match.m_ball.m_shape.getPosition ( ).y );
+        snapshot.fields[ Snapshot::BallAngle ]  = Snapshot::quantize_angle ( m_match.m_ball.m_angle );
+        snapshot.fields[ Snapshot::LeftY ]      = Snapshot::quantize_position ( m_match.m_left_paddle.m_shape.getPosition ( ).y );
+        snapshot.fields[ Snapshot::RightY ]     = Snapshot::quantize_position ( m_match.m_right_paddle.m_shape.getPosition ( ).y );
+        snapshot.fields[ Snapshot::ScoreLeft ]  = ( std::uint16_t ) m_match.m_score.m_left;
+        snapshot.fields[ Snapshot::ScoreRight ] = ( std::uint16_t ) m_match.m_score.m_right;
+        m_broadcast_server->publish ( snapshot );
     }
 
     void render_objects ( ) noexcept {
         m_render_window.clear ( sf::Color::Transparent );
         m_render_window.draw ( m_rim_sprite );
-        m_render_window.draw ( m_score.m_left_text );
-        m_render_window.draw ( m_score.m_right_text );
-        m_render_window.draw ( m_ball.m_shape );
-        m_render_window.draw ( m_player_paddle.m_shape );
-        m_render_window.draw ( m_computer_paddle.m_shape );
+        m_render_window.draw ( m_score_board.m_vertices, &*m_numbers.m_numbers_texture );
+        m_render_window.draw ( m_match.m_ball.m_shape );
+        m_render_window.draw ( m_match.m_right_paddle.m_shape );
+        m_render_window.draw ( m_match.m_left_paddle.m_shape );
+        m_render_window.draw ( m_lights );
+        if ( m_show_latency_marker ) {
+            // White iff this frame's sample moved, a sleeping paddle took none and leaves m_sample_moved stale.
+            const PlayerController & player = m_match.m_right_paddle.m_controller;
+            m_latency_marker.setFillColor ( player.m_has_sample and player.m_sample_moved ? sf::Color::White : sf::Color::Black );
+            m_render_window.draw ( m_latency_marker );
+        }
+        stamp ( pong::LatencyRecorder::Rendered );
         m_render_window.display ( );
+        stamp ( pong::LatencyRecorder::Displayed );
+    }
+
+    // The time (in microseconds) until the next frame that can change what's on screen, the ball and the computer paddle
+    // are asleep and the player didn't move, 0 if the next frame can.
+    float nothing_moves_for ( ) const noexcept {
+        const PlayerController & player = m_match.m_right_paddle.m_controller;
+        using Entity = decltype ( m_match )::Entity;
+        if ( ( player.m_has_sample and player.m_sample_moved ) or m_lights.is_animating ( ) or m_match.is_awake ( Entity::Ball ) or
+             m_match.is_awake ( Entity::Left ) ) {
+            return 0.0f;
+        }
+        return std::min ( m_match.wakes_in ( Entity::Ball ), m_match.wakes_in ( Entity::Left ) ) -
+               m_frame_duration_as_microseconds;
+    }
+
+    void stamp ( const pong::LatencyRecorder::Stage stage_ ) noexcept {
+        if ( m_latency_recorder ) {
+            m_latency_recorder->stamp ( stage_ );
+        }
+    }
+
+    // A sleeping paddle doesn't sample the mouse, those frames are not recorded.
+    void record_latency ( ) noexcept {
+        PlayerController & controller = m_match.m_right_paddle.m_controller;
+        if ( m_latency_recorder and controller.m_has_sample ) {
+            m_latency_recorder->record ( controller.m_sample_time );
+        }
+        controller.m_has_sample = false;
+    }
+};
+
+// Offline export: simulates a match (sequentially, it's cheap) and renders the frames on the cpu, on all cores, to a y4m
+// file or a png-sequence. No window and no gpu required.
+
+struct Exporter {
+
+    struct Options {
+        std::filesystem::path output;
+        std::uint64_t seed  = sax::os_seed ( );
+        std::size_t frames  = 60u * 60u;
+        std::size_t threads = std::thread::hardware_concurrency ( );
+        std::filesystem::path script; // One y per line for the right paddle, empty means ai.
+    };
+
+    // Everything needed to draw a frame, score_board indexes into m_score_boards.
+    struct FrameState {
+        sf::Point ball;
+        float left_y, right_y;
+        std::size_t score_board;
+    };
+
+    Options m_options;
+    pong::AssetCache m_assets;
+    pong::Asset<sf::Image> m_numbers_image;
+    pong::video::Framebuffer m_background;
+    std::vector<sf::VertexArray> m_score_boards; // One per distinct score.
+    std::vector<FrameState> m_frames;
+
+    Exporter ( const Options & options_ ) :
+        m_options ( options_ ), m_background ( pong::geometry::window_width, pong::geometry::window_height ) {
+        const pong::Asset<sf::Image> rim = m_assets.acquire<sf::Image> ( __PONG_RIM__ ); // Only needed here.
+        const sf::Image & rim_image      = *rim;
+        m_numbers_image                  = m_assets.acquire<sf::Image> ( __NUMBERS_TEXTURE__ );
+        m_background.clear ( sf::Color::Black );
+        m_background.blit ( rim_image, sf::IntRect ( 0, 0, rim_image.getSize ( ).x, rim_image.getSize ( ).y ), 0.0f, 0.0f,
+                            ( float ) rim_image.getSize ( ).x, ( float ) rim_image.getSize ( ).y );
+    }
+
+    int run ( ) {
+        if ( m_options.script.empty ( ) ) {
+            simulate<Paddle<pong::Side::Right, PredictiveController>> ( nullptr );
+        }
+        else {
+            std::vector<float> script;
+            std::ifstream stream ( m_options.script );
+            for ( float y; stream >> y; ) {
+                script.push_back ( y );
+            }
+            if ( not stream.eof ( ) ) {
+                std::cout << "Could not read script " << m_options.script.string ( ) << "." << nl;
+                return EXIT_FAILURE;
+            }
+            simulate<Paddle<pong::Side::Right, ScriptedController>> ( &script );
+        }
+        auto render = [ this ] ( const std::size_t i_, pong::video::Framebuffer & framebuffer_ ) {
+            draw ( m_frames[ i_ ], framebuffer_ );
+        };
+        if ( ".y4m" == m_options.output.extension ( ) ) {
+            pong::video::Y4mWriter writer ( m_options.output, pong::geometry::window_width, pong::geometry::window_height,
+                                            pong::geometry::tick_rate );
+            if ( not writer.is_open ( ) ) {
+                std::cout << "Could not open " << m_options.output.string ( ) << "." << nl;
+                return EXIT_FAILURE;
+            }
+            return write ( writer, render );
+        }
+        pong::video::PngSequenceWriter writer ( m_options.output );
+        if ( not writer.is_open ( ) ) {
+            std::cout << "Could not create " << m_options.output.parent_path ( ).string ( ) << ": " << writer.error ( ).message ( )
+                      << "." << nl;
+            return EXIT_FAILURE;
+        }
+        return write ( writer, render );
+    }
+
+    private:
+    // Renders all frames and writes them, fails iff writing failed.
+    template<typename Writer, typename Render>
+    int write ( Writer & writer_, Render && render_ ) {
+        pong::video::render_parallel ( m_frames.size ( ), pong::geometry::window_width, pong::geometry::window_height,
+                                       m_options.threads, render_, writer_ );
+        if ( not writer_.finish ( ) ) {
+            std::cout << "Could not write " << m_options.output.string ( ) << " (all of it)." << nl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "Exported " << m_frames.size ( ) << " frames (seed " << m_options.seed << ")." << nl;
+        return EXIT_SUCCESS;
+    }
+
+    // Runs the match until it's won or the frames run out, the left paddle is the heuristic ai.
+    template<typename RightPaddle>
+    void simulate ( const std::vector<float> * script_ ) {
+        const pong::RandomStreams random_streams ( m_options.seed );
+        Match<ComputerPaddle, RightPaddle> match ( random_streams );
+        match.create ( nullptr, 0, random_streams );
+        if constexpr ( std::is_same_v<ScriptedController, decltype ( match.m_right_paddle.m_controller )> ) {
+            match.m_right_paddle.m_controller.m_script = script_;
+        }
+        Sizes atlas = m_numbers_image->getSize ( );
+        atlas.width /= 10;
+        ScoreBoard score_board;
+        score_board.create ( pong::geometry::table_box ( ), atlas );
+        Score displayed;
+        m_score_boards.push_back ( score_board.m_vertices );
+        m_frames.reserve ( m_options.frames );
+        while ( m_frames.size ( ) < m_options.frames and not match.m_score.has_won ( ) ) {
+            match.step ( );
+            if ( match.m_score.m_left != displayed.m_left or match.m_score.m_right != displayed.m_right ) {
+                displayed = match.m_score;
+                score_board.update ( displayed );
+                m_score_boards.push_back ( score_board.m_vertices );
+            }
+            m_frames.push_back ( { match.m_ball.m_shape.getPosition ( ), match.m_left_paddle.m_shape.getPosition ( ).y,
+                                   match.m_right_paddle.m_shape.getPosition ( ).y, m_score_boards.size ( ) - 1u } );
+        }
+    }
+
+    void draw ( const FrameState & frame_, pong::video::Framebuffer & framebuffer_ ) const noexcept {
+        using namespace pong::geometry;
+        framebuffer_.m_pixels = m_background.m_pixels; // Same size, no allocation.
+        const sf::VertexArray & score_board = m_score_boards[ frame_.score_board ];
+        for ( std::size_t i = 0; i < score_board.getVertexCount ( ); i += 4u ) {
+            const sf::Vertex &top_left = score_board[ i ], &bottom_right = score_board[ i + 2u ];
+            const sf::Vector2f position = bottom_right.position - top_left.position;
+            const sf::Vector2f uv       = bottom_right.texCoords - top_left.texCoords;
+            framebuffer_.blit ( *m_numbers_image,
+                                sf::IntRect ( ( sf::Int32 ) top_left.texCoords.x, ( sf::Int32 ) top_left.texCoords.y,
+                                              ( sf::Int32 ) uv.x, ( sf::Int32 ) uv.y ),
+                                top_left.position.x, top_left.position.y, position.x, position.y, top_left.color );
+        }
+        framebuffer_.fill ( frame_.ball.x - 0.5f * ball_size, frame_.ball.y - 0.5f * ball_size, ball_size, ball_size,
+                            sf::Color ( 0xE1, 0xE1, 0xE1 ) );
+        framebuffer_.fill ( paddle_x<pong::Side::Left> - 0.5f * paddle_width, frame_.left_y - 0.5f * paddle_length, paddle_width,
+                            paddle_length, sf::Color ( 0xCB, 0xCB, 0xCB ) );
+        framebuffer_.fill ( paddle_x<pong::Side::Right> - 0.5f * paddle_width, frame_.right_y - 0.5f * paddle_length, paddle_width,
+                            paddle_length, sf::Color ( 0xCB, 0xCB, 0xCB ) );
     }
 };
 
-int main ( ) {
+// The whole of argument_ as a number, nothing if it isn't one.
+std::optional<std::uint64_t> parse_number ( const char * const argument_ ) noexcept {
+    const char * const end     = argument_ + std::strlen ( argument_ );
+    std::uint64_t number       = 0u;
+    const auto [ last, error ] = std::from_chars ( argument_, end, number );
+    if ( std::errc ( ) != error or end != last or argument_ == end ) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+// A port to bind or connect to, nothing if argument_ isn't one.
+std::optional<unsigned short> parse_port ( const char * const argument_ ) noexcept {
+    const std::optional<std::uint64_t> port = parse_number ( argument_ );
+    if ( not port or 0u == *port or *port > std::numeric_limits<unsigned short>::max ( ) ) {
+        return std::nullopt;
+    }
+    return ( unsigned short ) *port;
+}
+
+// pong --export <file.y4m | directory/prefix> [--seed n] [--frames n] [--threads n] [--script file]
+int export_match ( const int argc_, char ** const argv_ ) {
+    auto usage = [ ] {
+        std::cout << "usage: pong --export <file.y4m | directory/prefix> [--seed n] [--frames n] [--threads n] [--script file]"
+                  << nl;
+        return EXIT_FAILURE;
+    };
+    if ( argc_ < 3 or argc_ % 2 == 0 ) {
+        return usage ( );
+    }
+    Exporter::Options options;
+    options.output = argv_[ 2 ];
+    for ( int i = 3; i + 1 < argc_; i += 2 ) {
+        const std::string option ( argv_[ i ] );
+        if ( "--script" == option ) {
+            options.script = argv_[ i + 1 ];
+            continue;
+        }
+        const std::optional<std::uint64_t> value = parse_number ( argv_[ i + 1 ] );
+        if ( not value ) {
+            std::cout << "Not a number: " << argv_[ i + 1 ] << "." << nl;
+            return usage ( );
+        }
+        if ( "--seed" == option ) {
+            options.seed = *value;
+        }
+        else if ( "--frames" == option ) {
+            options.frames = *value;
+        }
+        else if ( "--threads" == option ) {
+            options.threads = *value;
+        }
+        else {
+            std::cout << "Unknown option " << option << "." << nl;
+            return usage ( );
+        }
+    }
+    return Exporter ( options ).run ( );
+}
+
+// pong --spectate-load <server> <port> <viewers> <seconds>
+int spectate_load ( const int argc_, char ** const argv_ ) {
+    auto usage = [ ] {
+        std::cout << "usage: pong --spectate-load <server> <port> <viewers> <seconds>" << nl;
+        return EXIT_FAILURE;
+    };
+    if ( argc_ != 6 ) {
+        return usage ( );
+    }
+    const sf::IpAddress server ( argv_[ 2 ] );
+    if ( sf::IpAddress::None == server ) {
+        std::cout << "Not an address: " << argv_[ 2 ] << "." << nl;
+        return usage ( );
+    }
+    const std::optional<unsigned short> port   = parse_port ( argv_[ 3 ] );
+    const std::optional<std::uint64_t> viewers = parse_number ( argv_[ 4 ] ), seconds = parse_number ( argv_[ 5 ] );
+    if ( not port or not viewers or not *viewers or not seconds or not *seconds or
+         *seconds > ( std::uint64_t ) std::numeric_limits<std::int32_t>::max ( ) ) {
+        std::cout << "Expected a port, a (non-zero) number of viewers and a (non-zero) number of seconds." << nl;
+        return usage ( );
+    }
+    return pong::broadcast::generate_viewer_load ( server, *port, *viewers, ( std::int32_t ) *seconds );
+}
+
+// After warming up, an iteration of the frame loop should not allocate, counts the allocations of frames_ iterations
+// (and with trace_ reports every allocating frame, with call sites). Fails iff anything allocated.
+int check_allocations ( App & app_, const bool trace_, const sf::Int32 warm_up_frames_ = 300, const sf::Int32 frames_ = 600 ) {
+    for ( sf::Int32 i = 0; i < warm_up_frames_ and app_.is_active ( ); ++i ) {
+        app_.run ( );
+    }
+    pong::allocation::Counter counter ( trace_ );
+    pong::allocation::Statistics total;
+    sf::Int32 allocating_frames = 0;
+    for ( sf::Int32 i = 0; i < frames_ and app_.is_active ( ); ++i ) {
+        counter.start ( );
+        app_.run ( );
+        const pong::allocation::Statistics frame = counter.stop ( );
+        if ( frame.count ) {
+            ++allocating_frames;
+            total.count += frame.count, total.bytes += frame.bytes;
+            if ( trace_ ) {
+                std::cout << "frame " << i << ": " << frame.count << " allocations, " << frame.bytes << " bytes" << nl;
+                counter.report ( std::cout );
+            }
+        }
+    }
+    std::cout << total.count << " allocations (" << total.bytes << " bytes) in " << allocating_frames << " of " << frames_
+              << " frames." << nl;
+    return total.count ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Measures the throughput of size environments, stepping with random actions, against the target of the training
+// setup (tens of millions of env-steps per second on a node). Fails iff a step allocated (on the calling thread, it
+// steps its share of the environments, with --threads 1 all of them).
+int benchmark_environments ( const int argc_, char ** const argv_ ) {
+    auto usage = [ ] {
+        std::cout << "usage: pong --benchmark-environments <size> [--frame-skip k] [--threads n] [--steps s]" << nl;
+        return EXIT_FAILURE;
+    };
+    constexpr double target = 10'000'000.0; // Env-steps per second.
+    if ( argc_ < 3 or argc_ % 2 == 0 ) {
+        return usage ( );
+    }
+    const std::optional<std::uint64_t> environments_argument = parse_number ( argv_[ 2 ] );
+    if ( not environments_argument or not *environments_argument ) {
+        std::cout << "Not a number of environments: " << argv_[ 2 ] << "." << nl;
+        return usage ( );
+    }
+    std::size_t frame_skip = 4u, threads = std::max ( 1u, std::thread::hardware_concurrency ( ) ), steps = 10'000u;
+    for ( int i = 3; i + 1 < argc_; i += 2 ) {
+        const std::string option ( argv_[ i ] );
+        const std::optional<std::uint64_t> value = parse_number ( argv_[ i + 1 ] );
+        if ( not value ) {
+            std::cout << "Not a number: " << argv_[ i + 1 ] << "." << nl;
+            return usage ( );
+        }
+        if ( "--frame-skip" == option ) {
+            frame_skip = *value;
+        }
+        else if ( "--threads" == option ) {
+            threads = *value;
+        }
+        else if ( "--steps" == option ) {
+            steps = *value;
+        }
+        else {
+            std::cout << "Unknown option " << option << "." << nl;
+            return usage ( );
+        }
+    }
+    const std::size_t size = *environments_argument;
+    Environments environments ( size, frame_skip, threads );
+    std::vector<float> observations ( size * Environments::observation_size ), rewards ( size );
+    std::vector<std::uint8_t> dones ( size );
+    std::vector<std::int32_t> actions ( size );
+    pong::RandomStream random ( sax::os_seed ( ), 0u );
+    environments.reset ( 0u, observations.data ( ) );
+    pong::allocation::Counter counter;
+    pong::allocation::Statistics allocations;
+    std::size_t episodes = 0u;
+    const auto start     = std::chrono::steady_clock::now ( );
+    for ( std::size_t s = 0; s < steps; ++s ) {
+        for ( std::int32_t & action : actions ) {
+            action = std::min ( ( std::int32_t ) ( 3.0f * random.uniform ( ) ), ( std::int32_t ) AgentController::Down );
+        }
+        counter.start ( );
+        environments.step ( actions.data ( ), observations.data ( ), rewards.data ( ), dones.data ( ) );
+        const pong::allocation::Statistics step = counter.stop ( );
+        allocations.count += step.count, allocations.bytes += step.bytes;
+        episodes += ( std::size_t ) std::count ( dones.begin ( ), dones.end ( ), std::uint8_t{ 1 } );
+    }
+    const double seconds = std::chrono::duration<double> ( std::chrono::steady_clock::now ( ) - start ).count ( );
+    const double rate    = size * steps / seconds;
+    std::cout << rate << " env-steps per second (" << ( rate * frame_skip ) << " frames per second) on " << environments.threads ( )
+              << " threads, " << ( 100.0 * rate / target ) << "% of the target of " << target << ", " << episodes
+              << " matches finished." << nl;
+    std::cout << allocations.count << " allocations (" << allocations.bytes << " bytes) in " << steps << " steps." << nl;
+    return allocations.count ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// pong [--broadcast port] [--latency | --latency-marker] [--check-allocations | --trace-allocations]
+// pong --export ... (see above)
+// pong --spectate-load ... (see above)
+// pong --benchmark-environments <size> [--frame-skip k] [--threads n] [--steps s]
+int main ( int argc_, char ** argv_ ) {
+    const std::string mode ( argc_ > 1 ? argv_[ 1 ] : "" );
+    if ( "--export" == mode ) {
+        return export_match ( argc_, argv_ );
+    }
+    if ( "--benchmark-environments" == mode ) {
+        return benchmark_environments ( argc_, argv_ );
+    }
+    if ( "--spectate-load" == mode ) {
+        return spectate_load ( argc_, argv_ );
+    }
+    // The options of a game, all checked before the window opens.
+    std::optional<unsigned short> broadcast_port;
+    bool measure_latency = false, latency_marker = false, check = false, trace = false;
+    for ( int i = 1; i < argc_; ++i ) {
+        const std::string option ( argv_[ i ] );
+        if ( "--broadcast" == option and i + 1 < argc_ and ( broadcast_port = parse_port ( argv_[ i + 1 ] ) ) ) {
+            ++i;
+        }
+        else if ( "--latency" == option or "--latency-marker" == option ) {
+            measure_latency = true, latency_marker = "--latency-marker" == option;
+        }
+        else if ( "--check-allocations" == option or "--trace-allocations" == option ) {
+            check = true, trace = "--trace-allocations" == option;
+        }
+        else {
+            std::cout << "usage: pong [--broadcast port] [--latency | --latency-marker] [--check-allocations | --trace-allocations]"
+                      << nl;
+            return EXIT_FAILURE;
+        }
+    }
     App app;
+    if ( measure_latency ) {
+        app.measure_latency ( latency_marker );
+    }
+    if ( broadcast_port and not app.broadcast ( *broadcast_port ) ) {
+        std::cout << "Could not bind port " << *broadcast_port << "." << nl;
+        return EXIT_FAILURE;
+    }
+    if ( check ) {
+        return check_allocations ( app, trace );
+    }
     while ( app.is_active ( ) ) {
         app.run ( );
     }
+    app.report_latency ( std::cout );
+    app.report_power ( std::cout );
+    app.report_assets ( std::cout );
     return EXIT_SUCCESS;
 }
 
@@ -679,184 +914,4 @@ render ( state );
 }
 
 
-
-
-#include <SFML/Graphics.hpp>
-
-class Light {
-    public:
-    Light ( const unsigned int id ) : id ( id ) { }
-
-    sf::Vector2f position;
-    sf::Color colour;
-    float radius;
-
-    bool operator==( const Light& right ) {
-        return id == right.id;
-    }
-
-    private:
-    unsigned int id;
-};
-
-class LightSystem : public sf::Drawable {
-    public:
-    LightSystem ( const sf::Vector2u& size, const sf::Color& colour, const sf::BlendMode& mode ) : ambient_light ( colour ), mode (
-mode ) { lightmap_texture.create ( size.x, size.y ); light_texture.loadFromFile ( "Light.png" ); light_texture.setSmooth ( true );
-        light_circle.setTexture ( &light_texture );
-    }
-
-    unsigned int add ( const sf::Vector2f& position, const sf::Color& colour, const float radius ) {
-        lights.emplace_back ( ++id_counter );
-
-        lights.back ( ).position = position;
-        lights.back ( ).colour = colour;
-        lights.back ( ).radius = radius;
-
-        return id_counter;
-    }
-
-    void remove ( const unsigned int id ) {
-        auto it = std::find ( lights.begin ( ), lights.end ( ), id );
-        if ( it == lights.end ( ) ) return;
-        lights.erase ( it );
-    }
-
-    void setPosition ( const unsigned int id, const sf::Vector2f& position ) {
-        auto it = std::find ( lights.begin ( ), lights.end ( ), id );
-        if ( it == lights.end ( ) ) return;
-        it->position = position;
-    }
-
-    void setColour ( const unsigned int id, const sf::Color& colour ) {
-        auto it = std::find ( lights.begin ( ), lights.end ( ), id );
-        if ( it == lights.end ( ) ) return;
-        it->colour = colour;
-    }
-
-    void setRadius ( const unsigned int id, const float radius ) {
-        auto it = std::find ( lights.begin ( ), lights.end ( ), id );
-        if ( it == lights.end ( ) ) return;
-        it->radius = radius;
-    }
-
-    void render ( ) {
-        lightmap_texture.clear ( ambient_light );
-        for ( auto& light : lights ) {
-            light_circle.setRadius ( light.radius );
-            light_circle.setOrigin ( light.radius, light.radius );
-            light_circle.setPosition ( light.position );
-            light_circle.setFillColor ( light.colour );
-            lightmap_texture.draw ( light_circle );
-        }
-        lightmap_texture.display ( );
-        lightmap_sprite.setTexture ( lightmap_texture.getTexture ( ) );
-    }
-
-    private:
-    virtual void draw ( sf::RenderTarget& target, sf::RenderStates states ) const {
-        target.draw ( lightmap_sprite, mode );
-    }
-
-    private:
-    std::vector<Light> lights;
-    sf::CircleShape light_circle;
-    sf::Texture light_texture;
-    sf::Sprite lightmap_sprite;
-    sf::RenderTexture lightmap_texture;
-    sf::Color ambient_light;
-    sf::BlendMode mode;
-    unsigned int id_counter;
-};
-
-int main ( ) {
-    sf::RenderWindow window ( sf::VideoMode ( 640, 480 ), "2D Lighting" );
-    window.setFramerateLimit ( 60 );
-    sf::Clock clock;
-    sf::Time delta;
-
-    sf::Texture world_texture;
-    world_texture.loadFromFile ( "World.png" );
-    sf::Sprite world ( world_texture );
-    sf::View view;
-    view.setSize ( static_cast<sf::Vector2f>( window.getSize ( ) ) );
-
-    sf::Texture player_texture;
-    player_texture.loadFromFile ( "Player.png" );
-    sf::Sprite player ( player_texture );
-    player.setOrigin ( static_cast<sf::Vector2f>( player_texture.getSize ( ) ) / 2.0f );
-    sf::Vector2f movement;
-    float speed = 200;
-
-    // Static lights.
-    LightSystem prelights ( window.getSize ( ) * ( unsigned ) 2, sf::Color ( 60, 60, 60 ), sf::BlendMultiply );
-    for ( int y = 0; y < 20; y += 2 )
-        for ( int x = 0; x < 20; x += 2 )
-            prelights.add ( sf::Vector2f ( y * 50.0f, x * 50.0f ), sf::Color::Red, 50.0f );
-    prelights.render ( );
-
-    // Dynamic lights.
-    LightSystem lights ( window.getSize ( ) * static_cast<unsigned int>( 2 ), sf::Color ( 255, 255, 255 ), sf::BlendMultiply );
-    auto light = lights.add ( player.getPosition ( ), sf::Color::Yellow, 75.0f );
-
-    sf::Event event;
-    while ( window.isOpen ( ) ) {
-        delta = clock.restart ( );
-
-        while ( window.pollEvent ( event ) ) {
-            if ( event.type == sf::Event::Closed )
-                window.close ( );
-            else if ( event.type == sf::Event::KeyPressed ) {
-                switch ( event.key.code ) {
-                case sf::Keyboard::W:
-                    movement.y = -speed;
-                    break;
-                case sf::Keyboard::S:
-                    movement.y = speed;
-                    break;
-                case sf::Keyboard::A:
-                    movement.x = -speed;
-                    break;
-                case sf::Keyboard::D:
-                    movement.x = speed;
-                    break;
-                case sf::Keyboard::Space:
-                    lights.setColour ( light, sf::Color::Cyan );
-                    break;
-                case sf::Keyboard::F:
-                    lights.setColour ( light, sf::Color::Yellow );
-                    break;
-                }
-            }
-            else if ( event.type == sf::Event::KeyReleased ) {
-                switch ( event.key.code ) {
-                case sf::Keyboard::W:
-                case sf::Keyboard::S:
-                    movement.y = 0.0f;
-                    break;
-                case sf::Keyboard::A:
-                case sf::Keyboard::D:
-                    movement.x = 0.0f;
-                    break;
-                }
-            }
-        }
-
-        player.move ( movement * delta.asSeconds ( ) );
-        lights.setPosition ( light, player.getPosition ( ) );
-        view.setCenter ( player.getPosition ( ) );
-
-        window.setView ( view );
-        window.clear ( );
-        window.draw ( world );
-        window.draw ( player );
-        window.draw ( prelights );
-        lights.render ( );
-        window.draw ( lights );
-        window.display ( );
-    }
-
-    return 0;
-}
-
 */
@@ -0,0 +1,153 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+
+namespace pong {
+
+// Counter-based random streams (Philox4x32-10, Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC11).
+//
+// A stream is a (seed, stream id) pair plus a counter, the i-th number of a stream is a pure function of those, so
+// streams are reproducible from the master seed and independent of each other and of the order in which they're used.
+// Samples are generated a block at a time, the lanes of a block have no dependencies, which lets the compiler
+// vectorize the rounds (vpmuludq on AVX2).
+
+[[nodiscard]] constexpr std::uint64_t splitmix64 ( std::uint64_t x_ ) noexcept {
+    x_ += 0x9E37'79B9'7F4A'7C15;
+    x_ = ( x_ ^ ( x_ >> 30 ) ) * 0xBF58'476D'1CE4'E5B9;
+    x_ = ( x_ ^ ( x_ >> 27 ) ) * 0x94D0'49BB'1331'11EB;
+    return x_ ^ ( x_ >> 31 );
+}
+
+class RandomStream {
+
+    public:
+    static constexpr std::size_t block_size = 256; // Number of floats per block, a multiple of 4.
+
+    static_assert ( block_size % 4 == 0 );
+
+    RandomStream ( ) noexcept : RandomStream ( 0u, 0u ) {}
+    RandomStream ( const std::uint64_t seed_, const std::uint64_t stream_id_ ) noexcept :
+        m_seed ( seed_ ), m_stream_id ( stream_id_ ), m_counter ( 0u ), m_uniform_index ( block_size ),
+        m_normal_index ( block_size ) {}
+
+    // A new, independent, stream. Splitting the same stream with the same child id gives the same stream.
+    [[nodiscard]] RandomStream split ( const std::uint64_t child_id_ ) const noexcept {
+        return RandomStream ( m_seed, splitmix64 ( m_stream_id ^ splitmix64 ( child_id_ + 1u ) ) );
+    }
+
+    // Uniform on [0, 1).
+    [[nodiscard]] float uniform ( ) noexcept {
+        if ( block_size == m_uniform_index ) {
+            fill_uniform ( );
+        }
+        return m_uniform[ m_uniform_index++ ];
+    }
+    // Uniform on [a, b).
+    [[nodiscard]] float uniform ( const float a_, const float b_ ) noexcept { return a_ + ( b_ - a_ ) * uniform ( ); }
+
+    // Normal with mean and standard deviation.
+    [[nodiscard]] float normal ( const float mean_ = 0.0f, const float stddev_ = 1.0f ) noexcept {
+        if ( block_size == m_normal_index ) {
+            fill_normal ( );
+        }
+        return mean_ + stddev_ * m_normal[ m_normal_index++ ];
+    }
+
+    [[nodiscard]] bool bernoulli ( const float p_ = 0.5f ) noexcept { return uniform ( ) < p_; }
+
+    [[nodiscard]] std::uint64_t seed ( ) const noexcept { return m_seed; }
+    [[nodiscard]] std::uint64_t stream_id ( ) const noexcept { return m_stream_id; }
+
+    private:
+    using Block = std::array<std::uint32_t, block_size>;
+
+    // Philox4x32-10 over block_size / 4 consecutive counters, the result in structure of arrays order.
+    void generate ( Block & out_ ) noexcept {
+        constexpr std::size_t lanes = block_size / 4;
+        constexpr std::uint32_t m0 = 0xD251'1F53, m1 = 0xCD9E'8D57, w0 = 0x9E37'79B9, w1 = 0xBB67'AE85;
+        std::uint32_t * const c0 = out_.data ( ), *const c1 = c0 + lanes, *const c2 = c1 + lanes, *const c3 = c2 + lanes;
+        for ( std::size_t i = 0; i < lanes; ++i ) {
+            const std::uint64_t counter = m_counter + i;
+            c0[ i ] = ( std::uint32_t ) counter, c1[ i ] = ( std::uint32_t ) ( counter >> 32 );
+            c2[ i ] = ( std::uint32_t ) m_stream_id, c3[ i ] = ( std::uint32_t ) ( m_stream_id >> 32 );
+        }
+        m_counter += lanes;
+        std::uint32_t k0 = ( std::uint32_t ) m_seed, k1 = ( std::uint32_t ) ( m_seed >> 32 );
+        for ( int round = 0; round < 10; ++round, k0 += w0, k1 += w1 ) {
+            for ( std::size_t i = 0; i < lanes; ++i ) {
+                const std::uint64_t p0 = ( std::uint64_t ) m0 * c0[ i ], p1 = ( std::uint64_t ) m1 * c2[ i ];
+                const std::uint32_t x0 = ( std::uint32_t ) ( p1 >> 32 ) ^ c1[ i ] ^ k0, x2 = ( std::uint32_t ) ( p0 >> 32 ) ^ c3[ i ] ^ k1;
+                c0[ i ] = x0, c1[ i ] = ( std::uint32_t ) p1, c2[ i ] = x2, c3[ i ] = ( std::uint32_t ) p0;
+            }
+        }
+    }
+
+    void fill_uniform ( ) noexcept {
+        Block bits;
+        generate ( bits );
+        for ( std::size_t i = 0; i < block_size; ++i ) {
+            m_uniform[ i ] = ( float ) ( bits[ i ] >> 8 ) * 0x1.0p-24f;
+        }
+        m_uniform_index = 0u;
+    }
+
+    // Box-Muller, the first half of the block are the radii, the second half the angles.
+    void fill_normal ( ) noexcept {
+        constexpr std::size_t half = block_size / 2;
+        constexpr float two_pi     = 6.283'185'307f;
+        Block bits;
+        generate ( bits );
+        for ( std::size_t i = 0; i < half; ++i ) {
+            const float u1 = ( float ) ( ( bits[ i ] >> 8 ) + 1u ) * 0x1.0p-24f; // (0, 1].
+            const float u2 = ( float ) ( bits[ i + half ] >> 8 ) * 0x1.0p-24f;
+            const float r  = std::sqrt ( -2.0f * std::log ( u1 ) );
+            m_normal[ i ] = r * std::cos ( two_pi * u2 ), m_normal[ i + half ] = r * std::sin ( two_pi * u2 );
+        }
+        m_normal_index = 0u;
+    }
+
+    std::uint64_t m_seed, m_stream_id, m_counter;
+    std::size_t m_uniform_index, m_normal_index;
+    alignas ( 32 ) std::array<float, block_size> m_uniform;
+    alignas ( 32 ) std::array<float, block_size> m_normal;
+};
+
+// Root of all streams of a match, one per entity.
+struct RandomStreams {
+
+    enum class Entity : std::uint64_t { Ball = 1, LeftPaddle = 2, RightPaddle = 3 };
+
+    RandomStream m_root;
+
+    explicit RandomStreams ( const std::uint64_t master_seed_ ) noexcept : m_root ( master_seed_, 0u ) {}
+
+    [[nodiscard]] RandomStream stream ( const Entity entity_ ) const noexcept { return m_root.split ( ( std::uint64_t ) entity_ ); }
+};
+} // namespace pong
@@ -30,5 +30,3 @@
 #define __HIT_WALL_SOUND__              111
 #define __HIT_PADDLE_SOUND__            112
 #define __MISS_BALL_SOUND__             113
-
-#define __NUMBERS_FONT__				126
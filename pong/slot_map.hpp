@@ -0,0 +1,132 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <utility>
+#include <vector>
+
+namespace pong {
+
+// A handle stays valid until its value is erased, after that it's stale (lookups fail), also once the slot is reused.
+struct Handle {
+    std::uint32_t index = ~std::uint32_t{ 0 }, generation = 0u;
+};
+
+// Generational slot map: O(1) insert, erase and lookup by handle, values are stored densely (in no particular order)
+// for iteration. Doesn't allocate as long as the number of values stays within the reserved capacity.
+template<typename T>
+class SlotMap {
+
+    public:
+    using value_type     = T;
+    using iterator       = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    void reserve ( const std::size_t capacity_ ) {
+        m_values.reserve ( capacity_ );
+        m_value_slots.reserve ( capacity_ );
+        m_slots.reserve ( capacity_ );
+    }
+
+    [[nodiscard]] Handle insert ( T value_ ) {
+        std::uint32_t index;
+        if ( none != m_free ) {
+            index  = m_free;
+            m_free = m_slots[ index ].dense; // Next free.
+        }
+        else {
+            index = ( std::uint32_t ) m_slots.size ( );
+            m_slots.push_back ( { 0u, 0u } );
+        }
+        m_slots[ index ].dense = ( std::uint32_t ) m_values.size ( );
+        m_values.push_back ( std::move ( value_ ) );
+        m_value_slots.push_back ( index );
+        return { index, m_slots[ index ].generation };
+    }
+
+    // Returns false iff the handle is stale.
+    bool erase ( const Handle handle_ ) noexcept {
+        if ( not contains ( handle_ ) ) {
+            return false;
+        }
+        Slot & slot = m_slots[ handle_.index ];
+        // Move the last value into the hole.
+        const std::uint32_t last = ( std::uint32_t ) m_values.size ( ) - 1u;
+        if ( slot.dense != last ) {
+            m_values[ slot.dense ]                       = std::move ( m_values[ last ] );
+            m_value_slots[ slot.dense ]                  = m_value_slots[ last ];
+            m_slots[ m_value_slots[ slot.dense ] ].dense = slot.dense;
+        }
+        m_values.pop_back ( );
+        m_value_slots.pop_back ( );
+        ++slot.generation;
+        slot.dense = m_free;
+        m_free     = handle_.index;
+        return true;
+    }
+
+    [[nodiscard]] bool contains ( const Handle handle_ ) const noexcept {
+        return handle_.index < m_slots.size ( ) and m_slots[ handle_.index ].generation == handle_.generation;
+    }
+
+    // nullptr iff the handle is stale.
+    [[nodiscard]] T * get ( const Handle handle_ ) noexcept {
+        return contains ( handle_ ) ? &m_values[ m_slots[ handle_.index ].dense ] : nullptr;
+    }
+    [[nodiscard]] const T * get ( const Handle handle_ ) const noexcept {
+        return contains ( handle_ ) ? &m_values[ m_slots[ handle_.index ].dense ] : nullptr;
+    }
+
+    // The handle of the value at dense position i_ (f.e. while iterating).
+    [[nodiscard]] Handle handle ( const std::size_t i_ ) const noexcept {
+        return { m_value_slots[ i_ ], m_slots[ m_value_slots[ i_ ] ].generation };
+    }
+
+    [[nodiscard]] std::size_t size ( ) const noexcept { return m_values.size ( ); }
+    [[nodiscard]] bool empty ( ) const noexcept { return m_values.empty ( ); }
+
+    iterator begin ( ) noexcept { return m_values.begin ( ); }
+    iterator end ( ) noexcept { return m_values.end ( ); }
+    const_iterator begin ( ) const noexcept { return m_values.begin ( ); }
+    const_iterator end ( ) const noexcept { return m_values.end ( ); }
+
+    T & operator[] ( const std::size_t i_ ) noexcept { return m_values[ i_ ]; }
+    const T & operator[] ( const std::size_t i_ ) const noexcept { return m_values[ i_ ]; }
+
+    private:
+    static constexpr std::uint32_t none = ~std::uint32_t{ 0 };
+
+    struct Slot {
+        std::uint32_t dense, generation; // Dense is the next free slot, if the slot is free.
+    };
+
+    std::vector<T> m_values;
+    std::vector<std::uint32_t> m_value_slots; // Dense index to slot.
+    std::vector<Slot> m_slots;
+    std::uint32_t m_free = none;
+};
+} // namespace pong
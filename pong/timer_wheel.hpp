@@ -0,0 +1,183 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+
+#include "slot_map.hpp"
+
+namespace pong {
+
+// Hierarchical timer wheel: levels of 64 slots, a slot of a level spans a whole level below it. A timer sits in the
+// lowest level in which its due time and the current time share all higher bits, it cascades down as time catches up
+// and fires from level 0. Advancing jumps from occupied slot to occupied slot, so its cost depends on the number of
+// timers, not on the time passed. The slots are intrusive lists through the timers, nothing allocates once the timers
+// are reserved.
+class TimerWheel {
+
+    public:
+    using Time = std::uint64_t; // Microseconds.
+
+    static constexpr std::size_t slot_bits = 6u, slots = std::size_t{ 1 } << slot_bits, levels = 6u;
+    static constexpr Time horizon = ( Time{ 1 } << ( slot_bits * levels ) ) - 1u; // Some 19 hours.
+
+    void reserve ( const std::size_t timers_ ) { m_timers.reserve ( timers_ ); }
+
+    [[nodiscard]] Time now ( ) const noexcept { return m_now; }
+
+    // Schedules event_ to fire at due_ (clamped to [ now, now + horizon ]).
+    [[nodiscard]] Handle schedule ( Time due_, const std::uint32_t event_ ) {
+        due_                = std::clamp ( due_, m_now, m_now + horizon );
+        const Handle handle = m_timers.insert ( { due_, event_ } );
+        link ( handle );
+        return handle;
+    }
+
+    // Returns false iff the timer fired or was cancelled already.
+    bool cancel ( const Handle handle_ ) noexcept {
+        if ( not m_timers.contains ( handle_ ) ) {
+            return false;
+        }
+        unlink ( handle_ );
+        return m_timers.erase ( handle_ );
+    }
+
+    // Cancels all timers and starts over at time 0, the reserved timers are kept.
+    void clear ( ) noexcept {
+        while ( not m_timers.empty ( ) ) {
+            m_timers.erase ( m_timers.handle ( m_timers.size ( ) - 1u ) );
+        }
+        m_now = 0u, m_occupied = { }, m_heads = { };
+    }
+
+    [[nodiscard]] bool is_pending ( const Handle handle_ ) const noexcept { return m_timers.contains ( handle_ ); }
+
+    // The due time of a pending timer, now otherwise.
+    [[nodiscard]] Time due ( const Handle handle_ ) const noexcept {
+        const Timer * timer = m_timers.get ( handle_ );
+        return timer ? timer->due : m_now;
+    }
+
+    // Moves the time forward to now_, fires (calls fire_ ( event )) the timers due by then, in order of their due time.
+    // fire_ can schedule and cancel timers.
+    template<typename Fire>
+    void advance ( const Time now_, Fire && fire_ ) {
+        std::size_t level, slot;
+        Time deadline;
+        while ( next_expiration ( level, slot, deadline ) and deadline <= now_ ) {
+            m_now = deadline;
+            // A level 0 slot spans a single microsecond, the timers in it are all due now. Higher up, they cascade down.
+            for ( Handle handle = m_heads[ level ][ slot ]; m_timers.contains ( handle ); handle = m_heads[ level ][ slot ] ) {
+                unlink ( handle );
+                if ( level ) {
+                    link ( handle );
+                }
+                else {
+                    const std::uint32_t event = m_timers.get ( handle )->event;
+                    m_timers.erase ( handle );
+                    fire_ ( event );
+                }
+            }
+        }
+        m_now = std::max ( m_now, now_ );
+    }
+
+    private:
+    struct Timer {
+        Time due;
+        std::uint32_t event;
+        std::uint32_t level = 0u, slot = 0u;
+        Handle previous = { }, next = { }; // In the slot.
+    };
+
+    [[nodiscard]] std::size_t level_for ( const Time due_ ) const noexcept {
+        const Time significant = 63u - ( Time ) std::countl_zero ( ( m_now ^ due_ ) | ( slots - 1u ) );
+        return std::min ( ( std::size_t ) significant / slot_bits, levels - 1u );
+    }
+
+    // Pushes the timer to the front of its slot.
+    void link ( const Handle handle_ ) noexcept {
+        Timer & timer           = *m_timers.get ( handle_ );
+        const std::size_t level = level_for ( timer.due );
+        const std::size_t slot  = ( std::size_t ) ( timer.due >> ( level * slot_bits ) ) & ( slots - 1u );
+        Handle & head           = m_heads[ level ][ slot ];
+        timer.level    = ( std::uint32_t ) level, timer.slot = ( std::uint32_t ) slot;
+        timer.previous = { }, timer.next = head;
+        if ( Timer * next = m_timers.get ( head ) ) {
+            next->previous = handle_;
+        }
+        head = handle_;
+        m_occupied[ level ] |= std::uint64_t{ 1 } << slot;
+    }
+
+    void unlink ( const Handle handle_ ) noexcept {
+        const Timer & timer = *m_timers.get ( handle_ );
+        if ( Timer * next = m_timers.get ( timer.next ) ) {
+            next->previous = timer.previous;
+        }
+        if ( Timer * previous = m_timers.get ( timer.previous ) ) {
+            previous->next = timer.next;
+        }
+        else {
+            m_heads[ timer.level ][ timer.slot ] = timer.next;
+            if ( not m_timers.contains ( timer.next ) ) {
+                m_occupied[ timer.level ] &= ~( std::uint64_t{ 1 } << timer.slot );
+            }
+        }
+    }
+
+    // The first occupied slot (the lowest occupied level holds the earliest) and the time it's due.
+    bool next_expiration ( std::size_t & level_, std::size_t & slot_, Time & deadline_ ) const noexcept {
+        for ( std::size_t level = 0; level < levels; ++level ) {
+            if ( not m_occupied[ level ] ) {
+                continue;
+            }
+            const std::size_t shift = level * slot_bits, now_slot = ( std::size_t ) ( m_now >> shift ) & ( slots - 1u );
+            // Above level 0, the slot of now itself can only hold timers of the next round, search it last.
+            const std::size_t first     = ( now_slot + ( level ? 1u : 0u ) ) & ( slots - 1u );
+            const std::uint64_t rotated = std::rotr ( m_occupied[ level ], ( int ) first );
+            const std::size_t slot      = ( first + ( std::size_t ) std::countr_zero ( rotated ) ) & ( slots - 1u );
+            const Time level_range      = Time{ 1 } << ( shift + slot_bits );
+            level_ = level, slot_ = slot;
+            deadline_ = ( m_now & ~( level_range - 1u ) ) + ( ( Time ) slot << shift );
+            if ( slot < now_slot or ( level and slot == now_slot ) ) {
+                deadline_ += level_range; // Only the top level wraps around.
+            }
+            return true;
+        }
+        return false;
+    }
+
+    Time m_now = 0u;
+    SlotMap<Timer> m_timers;
+    std::array<std::uint64_t, levels> m_occupied{ };
+    std::array<std::array<Handle, slots>, levels> m_heads{ };
+};
+} // namespace pong
@@ -0,0 +1,246 @@
+
+// MIT License
+//
+// Copyright (c) 2019 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Image.hpp>
+
+// Offline (GPU-less) frame rendering and video output.
+
+namespace pong::video {
+
+// RGBA, 8 bits per channel, rows top to bottom, the layout of sf::Image.
+struct Framebuffer {
+
+    std::int32_t m_width, m_height;
+    std::vector<std::uint8_t> m_pixels;
+
+    Framebuffer ( const std::int32_t width_, const std::int32_t height_ ) :
+        m_width ( width_ ), m_height ( height_ ), m_pixels ( ( std::size_t ) width_ * height_ * 4u ) {}
+
+    void clear ( const sf::Color & colour_ ) noexcept {
+        for ( std::size_t i = 0; i < m_pixels.size ( ); i += 4u ) {
+            m_pixels[ i ] = colour_.r, m_pixels[ i + 1 ] = colour_.g, m_pixels[ i + 2 ] = colour_.b, m_pixels[ i + 3 ] = colour_.a;
+        }
+    }
+
+    // Alpha-blends colour_ over the pixel at (x_, y_), the framebuffer stays opaque.
+    void blend ( const std::int32_t x_, const std::int32_t y_, const sf::Color & colour_ ) noexcept {
+        std::uint8_t * const p = m_pixels.data ( ) + ( ( std::size_t ) y_ * m_width + x_ ) * 4u;
+        const std::uint32_t a = colour_.a, ia = 255u - a;
+        p[ 0 ] = ( std::uint8_t ) ( ( colour_.r * a + p[ 0 ] * ia + 127u ) / 255u );
+        p[ 1 ] = ( std::uint8_t ) ( ( colour_.g * a + p[ 1 ] * ia + 127u ) / 255u );
+        p[ 2 ] = ( std::uint8_t ) ( ( colour_.b * a + p[ 2 ] * ia + 127u ) / 255u );
+    }
+
+    // Fills the axis-aligned rectangle [left_, left_ + width_) x [top_, top_ + height_), clipped.
+    void fill ( const float left_, const float top_, const float width_, const float height_,
+                const sf::Color & colour_ ) noexcept {
+        const std::int32_t x0 = std::max ( 0, ( std::int32_t ) left_ );
+        const std::int32_t x1 = std::min ( m_width, ( std::int32_t ) ( left_ + width_ ) );
+        const std::int32_t y0 = std::max ( 0, ( std::int32_t ) top_ );
+        const std::int32_t y1 = std::min ( m_height, ( std::int32_t ) ( top_ + height_ ) );
+        for ( std::int32_t y = y0; y < y1; ++y ) {
+            for ( std::int32_t x = x0; x < x1; ++x ) {
+                blend ( x, y, colour_ );
+            }
+        }
+    }
+
+    // Draws the (source) rectangle of image_ scaled to the destination rectangle, nearest neighbour, modulated by
+    // colour_ (like an sf::Vertex colour).
+    void blit ( const sf::Image & image_, const sf::IntRect & source_, const float left_, const float top_, const float width_,
+                const float height_, const sf::Color & colour_ = sf::Color::White ) noexcept {
+        const std::int32_t x0 = std::max ( 0, ( std::int32_t ) left_ );
+        const std::int32_t x1 = std::min ( m_width, ( std::int32_t ) ( left_ + width_ ) );
+        const std::int32_t y0 = std::max ( 0, ( std::int32_t ) top_ );
+        const std::int32_t y1 = std::min ( m_height, ( std::int32_t ) ( top_ + height_ ) );
+        const float sx = source_.width / width_, sy = source_.height / height_;
+        for ( std::int32_t y = y0; y < y1; ++y ) {
+            const unsigned v = ( unsigned ) ( source_.top + ( std::int32_t ) ( ( y - top_ ) * sy ) );
+            for ( std::int32_t x = x0; x < x1; ++x ) {
+                const unsigned u = ( unsigned ) ( source_.left + ( std::int32_t ) ( ( x - left_ ) * sx ) );
+                blend ( x, y, image_.getPixel ( u, v ) * colour_ );
+            }
+        }
+    }
+};
+
+// Frames are rendered and encoded out of order by the workers, the writer consumes them in order. A worker blocks
+// while its frame is capacity frames or more ahead of the writer, which bounds the memory in flight.
+class ReorderQueue {
+
+    public:
+    explicit ReorderQueue ( const std::size_t capacity_ ) : m_slots ( capacity_ ), m_next ( 0u ) {}
+
+    void push ( const std::size_t index_, std::vector<std::uint8_t> && frame_ ) {
+        std::unique_lock<std::mutex> lock ( m_mutex );
+        m_not_full.wait ( lock, [ this, index_ ] { return index_ < m_next + m_slots.size ( ); } );
+        m_slots[ index_ % m_slots.size ( ) ] = std::move ( frame_ );
+        m_not_empty.notify_all ( );
+    }
+
+    // The next frame in order.
+    [[nodiscard]] std::vector<std::uint8_t> pop ( ) {
+        std::unique_lock<std::mutex> lock ( m_mutex );
+        std::optional<std::vector<std::uint8_t>> & slot = m_slots[ m_next % m_slots.size ( ) ];
+        m_not_empty.wait ( lock, [ &slot ] { return slot.has_value ( ); } );
+        std::vector<std::uint8_t> frame = std::move ( *slot );
+        slot.reset ( );
+        ++m_next;
+        m_not_full.notify_all ( );
+        return frame;
+    }
+
+    private:
+    std::mutex m_mutex;
+    std::condition_variable m_not_full, m_not_empty;
+    std::vector<std::optional<std::vector<std::uint8_t>>> m_slots;
+    std::size_t m_next;
+};
+
+// YUV4MPEG2, 4:4:4, BT.601 studio range. Encoding runs on the workers, writing in order on the calling thread.
+class Y4mWriter {
+
+    public:
+    Y4mWriter ( const std::filesystem::path & path_, const std::int32_t width_, const std::int32_t height_,
+                const std::int32_t frame_rate_ ) :
+        m_stream ( path_, std::ios::binary ) {
+        m_stream << "YUV4MPEG2 W" << width_ << " H" << height_ << " F" << frame_rate_ << ":1 Ip A1:1 C444\n";
+    }
+
+    // False iff the file couldn't be opened or its header written.
+    bool is_open ( ) const noexcept { return m_stream.is_open ( ) and m_stream.good ( ); }
+
+    // Closes the file, returns false iff any write failed (f.e. the disk is full).
+    bool finish ( ) {
+        m_stream.close ( );
+        return not m_stream.fail ( );
+    }
+
+    void encode ( const std::size_t, const Framebuffer & framebuffer_, std::vector<std::uint8_t> & out_ ) const {
+        constexpr char tag[] = "FRAME\n";
+        const std::size_t n  = ( std::size_t ) framebuffer_.m_width * framebuffer_.m_height;
+        out_.resize ( sizeof ( tag ) - 1u + 3u * n );
+        std::copy ( tag, tag + sizeof ( tag ) - 1u, out_.begin ( ) );
+        std::uint8_t *y = out_.data ( ) + sizeof ( tag ) - 1u, *u = y + n, *v = u + n;
+        const std::uint8_t * p = framebuffer_.m_pixels.data ( );
+        for ( std::size_t i = 0; i < n; ++i, p += 4 ) {
+            const std::int32_t r = p[ 0 ], g = p[ 1 ], b = p[ 2 ];
+            y[ i ] = ( std::uint8_t ) ( ( ( 66 * r + 129 * g + 25 * b + 128 ) >> 8 ) + 16 );
+            u[ i ] = ( std::uint8_t ) ( ( ( -38 * r - 74 * g + 112 * b + 128 ) >> 8 ) + 128 );
+            v[ i ] = ( std::uint8_t ) ( ( ( 112 * r - 94 * g - 18 * b + 128 ) >> 8 ) + 128 );
+        }
+    }
+
+    void write ( const std::vector<std::uint8_t> & frame_ ) {
+        m_stream.write ( ( const char * ) frame_.data ( ), ( std::streamsize ) frame_.size ( ) );
+    }
+
+    private:
+    std::ofstream m_stream;
+};
+
+// A numbered sequence of png's (prefix_000000.png, ...). Every frame is its own file, so the workers compress and write
+// them directly, nothing goes through the queue.
+class PngSequenceWriter {
+
+    public:
+    explicit PngSequenceWriter ( std::filesystem::path prefix_ ) : m_prefix ( std::move ( prefix_ ) ) {
+        if ( m_prefix.has_parent_path ( ) ) {
+            std::filesystem::create_directories ( m_prefix.parent_path ( ), m_error );
+        }
+    }
+
+    // False iff the directory couldn't be created, error ( ) tells why.
+    bool is_open ( ) const noexcept { return not m_error; }
+    const std::error_code & error ( ) const noexcept { return m_error; }
+
+    // Returns false iff a frame couldn't be saved.
+    bool finish ( ) const noexcept { return not m_failed; }
+
+    void encode ( const std::size_t index_, const Framebuffer & framebuffer_, std::vector<std::uint8_t> & out_ ) const {
+        char number[ 16 ];
+        std::snprintf ( number, sizeof ( number ), "_%06zu.png", index_ );
+        sf::Image image;
+        image.create ( ( unsigned ) framebuffer_.m_width, ( unsigned ) framebuffer_.m_height, framebuffer_.m_pixels.data ( ) );
+        if ( not image.saveToFile ( m_prefix.string ( ) + number ) ) {
+            m_failed = true;
+        }
+        out_.clear ( );
+    }
+
+    void write ( const std::vector<std::uint8_t> & ) noexcept {}
+
+    private:
+    std::filesystem::path m_prefix;
+    std::error_code m_error;
+    mutable std::atomic<bool> m_failed = false; // Set by the workers.
+};
+
+// Renders frames [0, frames_) on threads_ workers, render_ ( index, framebuffer ) draws a frame, writer_ encodes it
+// (on the worker) and writes it (in order, on the calling thread).
+template<typename Render, typename Writer>
+void render_parallel ( const std::size_t frames_, const std::int32_t width_, const std::int32_t height_, std::size_t threads_,
+                       Render && render_, Writer & writer_ ) {
+    threads_ = std::max<std::size_t> ( 1u, threads_ );
+    ReorderQueue queue ( 4u * threads_ );
+    std::atomic<std::size_t> next_frame = 0u;
+    std::vector<std::thread> workers;
+    workers.reserve ( threads_ );
+    for ( std::size_t t = 0; t < threads_; ++t ) {
+        workers.emplace_back ( [ & ] {
+            Framebuffer framebuffer ( width_, height_ );
+            for ( std::size_t i = next_frame++; i < frames_; i = next_frame++ ) {
+                std::vector<std::uint8_t> encoded;
+                render_ ( i, framebuffer );
+                writer_.encode ( i, framebuffer, encoded );
+                queue.push ( i, std::move ( encoded ) );
+            }
+        } );
+    }
+    for ( std::size_t i = 0; i < frames_; ++i ) {
+        writer_.write ( queue.pop ( ) );
+    }
+    for ( std::thread & worker : workers ) {
+        worker.join ( );
+    }
+}
+} // namespace pong::video